@@ -10,7 +10,24 @@ HEADERS = \
        editview.h \
        attredit.h \
        jcteditor.h \
-       tleditor.h
+       tleditor.h \
+       renderbatch.h \
+       exporter.h \
+       paintstats.h \
+       statsoverlay.h \
+       minimap.h \
+       animator.h \
+       colourramp.h \
+       attributetable.h \
+       labellayer.h \
+       snapindex.h \
+       turngenerator.h \
+       searchindex.h \
+       searchview.h \
+       query.h \
+       transformdialog.h \
+       netwriter.h \
+       netsource.h
 SOURCES = \
        main.cpp \
        mainwindow.cpp \
@@ -24,9 +41,29 @@ SOURCES = \
        editview.cpp \
        attredit.cpp \
        jcteditor.cpp \
-       tleditor.cpp
+       tleditor.cpp \
+       renderbatch.cpp \
+       exporter.cpp \
+       paintstats.cpp \
+       statsoverlay.cpp \
+       minimap.cpp \
+       animator.cpp \
+       colourramp.cpp \
+       attributetable.cpp \
+       labellayer.cpp \
+       snapindex.cpp \
+       turngenerator.cpp \
+       searchindex.cpp \
+       searchview.cpp \
+       query.cpp \
+       transformdialog.cpp \
+       netwriter.cpp \
+       netsource.cpp
 CONFIG  += qt debug
-QT      += xml widgets
+QT      += xml widgets svg concurrent
+
+# zlib is used to stream large PNG exports
+LIBS    += -lz
 
 # install
 # INSTALLS += target
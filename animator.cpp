@@ -0,0 +1,121 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#include "animator.h"
+#include "pathelement.h"
+#include "pointelement.h"
+
+#include <QTimerEvent>
+
+Animator::Animator(QObject *parent) : QObject(parent)
+{
+    clock.start();
+}
+
+void Animator::blink(PathElement *element)
+{
+    start(element, 0, -1);
+}
+
+void Animator::blink(PathElement *element, int node)
+{
+    start(element, 0, node);
+}
+
+void Animator::blink(PointElement *element)
+{
+    start(0, element, -1);
+}
+
+void Animator::clear()
+{
+    animations.clear();
+    timer.stop();
+}
+
+int Animator::count() const
+{
+    return animations.count();
+}
+
+void Animator::start(PathElement *path, PointElement *point, int node)
+{
+    // Remove a running animation of the same element, switching its highlight off
+    for (int i = 0; i < animations.count(); ++i)
+        if (animations[i].path == path && animations[i].point == point && animations[i].node == node)
+        {
+            apply(animations[i], false);
+            animations.removeAt(i);
+            break;
+        }
+
+    Animation animation;
+    animation.path = path;
+    animation.point = point;
+    animation.node = node;
+    animation.phase = 0;
+    animation.start = clock.elapsed();
+    animations.append(animation);
+
+    // The timer only runs while there are animations
+    if (!timer.isActive())
+        timer.start(frameInterval, this);
+}
+
+void Animator::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() != timer.timerId())
+    {
+        QObject::timerEvent(event);
+        return;
+    }
+
+    // The phase of each animation follows the clock, so late frames do not slow the animations down;
+    // elements are only repainted when their phase changes
+    qint64 now = clock.elapsed();
+    for (int i = animations.count() - 1; i >= 0; --i)
+    {
+        int phase = int((now - animations[i].start) / blinkInterval);
+        if (phase == animations[i].phase) continue;
+
+        if (phase >= blinkPhases)
+        {
+            apply(animations[i], false);
+            animations.removeAt(i);
+        }
+        else
+        {
+            animations[i].phase = phase;
+            apply(animations[i], phase % 2 == 1);
+        }
+    }
+
+    if (animations.isEmpty())
+        timer.stop();
+}
+
+void Animator::apply(const Animation &animation, bool on)
+{
+    if (animation.path)
+        animation.path->setBlink(on, animation.node);
+    else
+        animation.point->setBlink(on);
+}
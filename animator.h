@@ -0,0 +1,86 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#ifndef ANIMATOR_H
+#define ANIMATOR_H
+
+#include <QObject>
+#include <QList>
+#include <QBasicTimer>
+#include <QElapsedTimer>
+
+class PathElement;
+class PointElement;
+
+class Animator : public QObject
+{
+    Q_OBJECT
+public:
+    // Constructor; there is one animator per network view
+    explicit Animator(QObject *parent = 0);
+
+    // Blinks a whole path element, one node of it, or a point element
+    // Blinking an element again restarts its animation
+    void blink(PathElement *element);
+    void blink(PathElement *element, int node);
+    void blink(PointElement *element);
+
+    // Stops all animations without touching the elements; called before the elements are deleted
+    void clear();
+
+    // Returns the number of running animations
+    int count() const;
+
+protected:
+    // Advances all the animations by one frame
+    void timerEvent(QTimerEvent *event);
+
+private:
+    // An animation of an element; only one of the element pointers is set
+    struct Animation
+    {
+        PathElement *path;
+        PointElement *point;
+        int node;
+        int phase;
+        qint64 start;
+    };
+
+    // Running animations
+    QList<Animation> animations;
+
+    // Single timer driving all the animations, and clock the phases are derived from
+    QBasicTimer timer;
+    QElapsedTimer clock;
+
+    // Frame interval, and duration and number of the blinking phases, in milliseconds
+    static const int frameInterval = 16;
+    static const int blinkInterval = 100;
+    static const int blinkPhases = 6;
+
+    // Adds an animation, replacing a running one of the same element and node
+    void start(PathElement *path, PointElement *point, int node);
+
+    // Shows or hides the highlight of an animation; the element repaints only the affected area
+    void apply(const Animation &animation, bool on);
+};
+
+#endif // ANIMATOR_H
@@ -42,6 +42,9 @@ AttrEdit::AttrEdit(const QString &text, QWidget *parent) : QHBoxLayout(parent)
     connect(ledit, SIGNAL(returnPressed()), this, SLOT(acceptChangedText()));
     connect(combo, SIGNAL(activated(QString)), this, SLOT(acceptChangedCombo(QString)));
     textEdited = false;
+    mixed = false;
+    model = 0;
+    item = 0;
 }
 
 void AttrEdit::onTextChanged(QString text)
@@ -57,11 +60,12 @@ void AttrEdit::onTextChanged(QString text)
     textEdited = true;
 }
 
-void AttrEdit::setAttribute(QString elementType, QString attr, QString value, bool enabled)
+void AttrEdit::setAttribute(QString elementType, QString attr, QString value, bool enabled, bool mixed)
 {
     // Reassign values for the AttrEdit
     this->attr = attr;
     this->value = value;
+    this->mixed = mixed;
 
     // Decide whether to show the LineEdit or the ComboBox
     // Based on net_file.xsd schema in SUMO 0.21.0
@@ -86,9 +90,10 @@ void AttrEdit::setAttribute(QString elementType, QString attr, QString value, bo
     if (isCombo)
     {
         combo->clear();
+        if (mixed) combo->addItem(tr("(mixed values)"));
         combo->addItems(options);
 #if QT_VERSION >= 0x040000
-        int index = combo->findText(value);
+        int index = (mixed ? 0 : combo->findText(value));
         combo->setCurrentIndex(index);
 #elif QT_VERSION >= 0x050000
         combo->setCurrentText(value);
@@ -100,6 +105,7 @@ void AttrEdit::setAttribute(QString elementType, QString attr, QString value, bo
     else
     {
         ledit->setText(value);
+        ledit->setPlaceholderText(mixed ? tr("(mixed values)") : QString());
         ledit->setStyleSheet(defaultStyleSheet);
         ledit->setEnabled(enabled);
         ledit->show();
@@ -123,7 +129,7 @@ void AttrEdit::acceptChangedText()
 
         // Update attribute in XML domDocument
         value = ledit->text();
-        model->editAttribute(item->xmlNode, item->xmlSubNode, attr, value);
+        apply();
 
         // Update statusBar
         emit statusUpdate(tr("Ready"));
@@ -134,14 +140,28 @@ void AttrEdit::acceptChangedText()
 
 void AttrEdit::acceptChangedCombo(QString newValue)
 {
-    if (newValue != value)
+    // The mixed values entry only shows that the selected elements differ
+    if (mixed && combo->currentIndex() == 0) return;
+
+    if (newValue != value || mixed)
     {
         // Update attribute in XML domDocument
+        if (mixed) combo->removeItem(0);
         value = newValue;
-        model->editAttribute(item->xmlNode, item->xmlSubNode, attr, value);
+        apply();
     }
 }
 
+void AttrEdit::apply()
+{
+    // All the selected elements are written in one batched update
+    if (item)
+        model->editAttribute(item->xmlNode, item->xmlSubNode, attr, value);
+    else
+        model->setSelectionAttribute(attr, value);
+    mixed = false;
+}
+
 void AttrEdit::hide()
 {
     // Hide both the LineEdit and the ComboBox
@@ -39,10 +39,12 @@ public:
     AttrEdit(const QString &text, QWidget *parent = 0);
 
     // Shows the LineEdit or ComboBox when a new element is selected and resets them;
-    // called by EditView::selectionChanged
-    void setAttribute(QString elementType, QString attr, QString value, bool enabled);
+    // called by EditView::selectionChanged. With 'mixed' the selected elements have different
+    // values, and the edit shows so until a value is entered
+    void setAttribute(QString elementType, QString attr, QString value, bool enabled, bool mixed = false);
 
-    // Set references to the model and the item clicked
+    // Set references to the model and the item clicked; without an item, changes are applied
+    // to all the elements selected in the network view
     void setModelAndItem(Model *model, Item *item);
 
     // Hide function
@@ -81,6 +83,12 @@ private:
 
     // True if the text has been modified
     bool textEdited;
+
+    // True while the selected elements have different values
+    bool mixed;
+
+    // Writes the value into the item, or into the whole element selection
+    void apply();
 };
 
 #endif // ATTREDIT_H
@@ -0,0 +1,192 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#include "attributetable.h"
+#include "pathelement.h"
+#include "item.h"
+
+#include <QObject>
+#include <qnumeric.h>
+
+AttributeTable::AttributeTable()
+{
+}
+
+void AttributeTable::clear()
+{
+    elements.clear();
+    for (int c = 0; c < ColumnCount; ++c)
+        columns[c].clear();
+    rows.clear();
+}
+
+int AttributeTable::addRow(PathElement *element, int xmlNode, int xmlSubNode)
+{
+    int row = elements.count();
+    elements.append(element);
+    for (int c = 0; c < ColumnCount; ++c)
+        columns[c].append(qQNaN());
+    rows.insert(key(xmlNode, xmlSubNode), row);
+    return row;
+}
+
+void AttributeTable::setValue(int row, int column, float value)
+{
+    columns[column][row] = value;
+}
+
+void AttributeTable::setValue(int row, int column, const QString &text)
+{
+    bool ok;
+    float value = text.toFloat(&ok);
+    columns[column][row] = (ok ? value : float(qQNaN()));
+}
+
+void AttributeTable::setEdge(int edgeRow, const QList<int> &laneRows, const QString &priority)
+{
+    // Lanes without a width attribute have the SUMO default width
+    for (int i = 0; i < laneRows.count(); ++i)
+    {
+        setValue(laneRows[i], Priority, priority);
+        setValue(laneRows[i], LaneCount, float(laneRows.count()));
+        if (qIsNaN(columns[Width][laneRows[i]])) setValue(laneRows[i], Width, 3.2f);
+    }
+    if (edgeRow < 0) return;
+
+    // The edge takes the mean of the speed, length and width of its lanes
+    Column averaged[] = { Speed, Length, Width };
+    for (int c = 0; c < 3; ++c)
+    {
+        float sum = 0;
+        int n = 0;
+        for (int i = 0; i < laneRows.count(); ++i)
+            if (!qIsNaN(columns[averaged[c]][laneRows[i]]))
+            {
+                sum += columns[averaged[c]][laneRows[i]];
+                ++n;
+            }
+        setValue(edgeRow, averaged[c], (n > 0 ? sum / n : float(qQNaN())));
+    }
+    setValue(edgeRow, Priority, priority);
+    setValue(edgeRow, LaneCount, float(laneRows.count()));
+}
+
+float AttributeTable::value(int row, int column) const
+{
+    return columns[column][row];
+}
+
+const QVector<float> &AttributeTable::values(int column) const
+{
+    return columns[column];
+}
+
+PathElement *AttributeTable::element(int row) const
+{
+    return elements[row];
+}
+
+int AttributeTable::rowCount() const
+{
+    return elements.count();
+}
+
+int AttributeTable::findRow(int xmlNode, int xmlSubNode) const
+{
+    return rows.value(key(xmlNode, xmlSubNode), -1);
+}
+
+void AttributeTable::reindex()
+{
+    rows.clear();
+    for (int row = 0; row < elements.count(); ++row)
+    {
+        if (elements[row]->scene())
+        {
+            Item *item = elements[row]->getItem();
+            rows.insert(key(item->xmlNode, item->xmlSubNode), row);
+        }
+        else
+            for (int c = 0; c < ColumnCount; ++c)
+                columns[c][row] = qQNaN();
+    }
+}
+
+int AttributeTable::columnOf(const QString &attribute)
+{
+    if (attribute == "speed") return Speed;
+    if (attribute == "length") return Length;
+    if (attribute == "priority") return Priority;
+    if (attribute == "width") return Width;
+    return -1;
+}
+
+QString AttributeTable::columnName(int column)
+{
+    switch (column)
+    {
+        case Speed:     return QObject::tr("Speed");
+        case Length:    return QObject::tr("Length");
+        case Priority:  return QObject::tr("Priority");
+        case Width:     return QObject::tr("Width");
+        case LaneCount: return QObject::tr("Lane count");
+        default:        return QString();
+    }
+}
+
+bool AttributeTable::range(int column, float &min, float &max) const
+{
+    const float *v = columns[column].constData();
+    const int n = columns[column].count();
+    bool found = false;
+    for (int i = 0; i < n; ++i)
+    {
+        if (qIsNaN(v[i])) continue;
+        if (!found) { min = max = v[i]; found = true; }
+        else if (v[i] < min) min = v[i];
+        else if (v[i] > max) max = v[i];
+    }
+    return found;
+}
+
+void AttributeTable::colourise(int column, const ColourRamp &ramp, float min, float max, QVector<QRgb> &colours) const
+{
+    const float *v = columns[column].constData();
+    const int n = columns[column].count();
+    const QRgb *table = ramp.table().constData();
+    const float last = ColourRamp::tableSize - 1;
+    const float scale = (max > min ? last / (max - min) : 0);
+
+    // A single pass over the column: scale, clip and look the colour up; NaN fails the
+    // comparison with itself and gets no colour
+    colours.resize(n);
+    QRgb *out = colours.data();
+    for (int i = 0; i < n; ++i)
+    {
+        float t = qBound(0.0f, (v[i] - min) * scale, last);
+        out[i] = (v[i] == v[i] ? table[int(t + 0.5f)] : QRgb(0));
+    }
+}
+
+qint64 AttributeTable::key(int xmlNode, int xmlSubNode)
+{
+    return (qint64(xmlNode) << 32) | quint32(xmlSubNode);
+}
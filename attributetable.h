@@ -0,0 +1,96 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#ifndef ATTRIBUTETABLE_H
+#define ATTRIBUTETABLE_H
+
+#include "colourramp.h"
+
+#include <QVector>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QColor>
+
+class PathElement;
+
+class AttributeTable
+{
+public:
+    // Numeric columns; lanes take the priority and lane count of their edge, and edges
+    // take the mean speed, length and width of their lanes
+    enum Column { Speed, Length, Priority, Width, LaneCount, ColumnCount };
+
+    // Constructor
+    AttributeTable();
+
+    // Removes all rows
+    void clear();
+
+    // Adds a row for the Path Element of an edge or a lane at the given XML location; returns the row
+    int addRow(PathElement *element, int xmlNode, int xmlSubNode);
+
+    // Sets a value, either as a number or as the text of an XML attribute; missing values are NaN
+    void setValue(int row, int column, float value);
+    void setValue(int row, int column, const QString &text);
+
+    // Fills in the values the lanes and their edge take from each other; edgeRow may be -1
+    void setEdge(int edgeRow, const QList<int> &laneRows, const QString &priority);
+
+    // Table access
+    float value(int row, int column) const;
+    const QVector<float> &values(int column) const;
+    PathElement *element(int row) const;
+    int rowCount() const;
+
+    // Returns the row of an XML element, or -1
+    int findRow(int xmlNode, int xmlSubNode) const;
+
+    // Finds the rows again from the XML location of the model items after elements were deleted;
+    // the rows of elements no longer in the scene are kept, without values, so that row numbers stay valid
+    void reindex();
+
+    // Column of an XML attribute name, or -1 if the attribute is not in the table
+    static int columnOf(const QString &attribute);
+
+    // Caption of a column, for the Controls view
+    static QString columnName(int column);
+
+    // Minimum and maximum of the defined values of a column; returns false if there are none
+    bool range(int column, float &min, float &max) const;
+
+    // Maps a column to colours in one pass, clipping the values to [min, max];
+    // rows with missing values get a transparent colour (no override)
+    void colourise(int column, const ColourRamp &ramp, float min, float max, QVector<QRgb> &colours) const;
+
+private:
+    // Graphic element of each row
+    QVector<PathElement*> elements;
+
+    // One vector per column, indexed by row
+    QVector<float> columns[ColumnCount];
+
+    // Row of each XML element, keyed by node and subnode
+    QHash<qint64, int> rows;
+    static qint64 key(int xmlNode, int xmlSubNode);
+};
+
+#endif // ATTRIBUTETABLE_H
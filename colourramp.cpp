@@ -0,0 +1,79 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#include "colourramp.h"
+
+#include <QObject>
+
+ColourRamp::ColourRamp(Preset preset)
+{
+    // Colour stops, evenly spaced along the ramp
+    QVector<QColor> stops;
+    switch (preset)
+    {
+        case RedYellowGreen:
+            stops << QColor(215, 25, 28) << QColor(253, 174, 97) << QColor(255, 255, 191) << QColor(166, 217, 106) << QColor(26, 150, 65); break;
+        case BlueRed:
+            stops << QColor(44, 123, 182) << QColor(171, 217, 233) << QColor(255, 255, 191) << QColor(253, 174, 97) << QColor(215, 25, 28); break;
+        case Greyscale:
+            stops << QColor(32, 32, 32) << QColor(224, 224, 224); break;
+        default:
+            stops << QColor(68, 1, 84) << QColor(59, 82, 139) << QColor(33, 145, 140) << QColor(94, 201, 98) << QColor(253, 231, 37); break;
+    }
+
+    // Interpolate the stops linearly into the lookup table
+    lookup.resize(tableSize);
+    int segments = stops.count() - 1;
+    for (int i = 0; i < tableSize; ++i)
+    {
+        qreal t = qreal(i) * segments / (tableSize - 1);
+        int k = qMin(int(t), segments - 1);
+        qreal f = t - k;
+        const QColor &a = stops[k];
+        const QColor &b = stops[k + 1];
+        lookup[i] = qRgb(qRound(a.red() + f * (b.red() - a.red())),
+                         qRound(a.green() + f * (b.green() - a.green())),
+                         qRound(a.blue() + f * (b.blue() - a.blue())));
+    }
+}
+
+QString ColourRamp::name(int preset)
+{
+    switch (preset)
+    {
+        case Viridis:        return QObject::tr("Viridis");
+        case RedYellowGreen: return QObject::tr("Red - Yellow - Green");
+        case BlueRed:        return QObject::tr("Blue - Red");
+        case Greyscale:      return QObject::tr("Greyscale");
+        default:             return QString();
+    }
+}
+
+QRgb ColourRamp::colourAt(float t) const
+{
+    int i = int(qBound(0.0f, t, 1.0f) * (tableSize - 1) + 0.5f);
+    return lookup[i];
+}
+
+const QVector<QRgb> &ColourRamp::table() const
+{
+    return lookup;
+}
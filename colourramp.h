@@ -0,0 +1,54 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#ifndef COLOURRAMP_H
+#define COLOURRAMP_H
+
+#include <QVector>
+#include <QColor>
+#include <QString>
+
+class ColourRamp
+{
+public:
+    // Predefined ramps
+    enum Preset { Viridis, RedYellowGreen, BlueRed, Greyscale, PresetCount };
+
+    // Number of entries in the lookup table
+    static const int tableSize = 256;
+
+    // Constructor; builds the lookup table of the preset
+    explicit ColourRamp(Preset preset = Viridis);
+
+    // Name of a preset, for the Controls view
+    static QString name(int preset);
+
+    // Colour at position t, clipped to [0, 1]
+    QRgb colourAt(float t) const;
+
+    // Lookup table from the low end (index 0) to the high end of the ramp
+    const QVector<QRgb> &table() const;
+
+private:
+    QVector<QRgb> lookup;
+};
+
+#endif // COLOURRAMP_H
@@ -20,12 +20,15 @@
 
 
 #include "controls.h"
+#include "attributetable.h"
 
 #include <QLabel>
 #include <QGridLayout>
 
 Controls::Controls(QWidget *parent) : QWidget(parent)
 {
+    model = 0;
+
     // Create labels and check boxes
     QLabel *icon1 = new QLabel; icon1->setPixmap(QPixmap(":/icons/edge1616.png"));
     QLabel *icon2 = new QLabel; icon2->setPixmap(QPixmap(":/icons/nmlLane1616.png"));
@@ -68,6 +71,21 @@ Controls::Controls(QWidget *parent) : QWidget(parent)
     arrow3 = new QCheckBox(); arrow3->setFocusPolicy(Qt::NoFocus);
     arrow7 = new QCheckBox(); arrow7->setFocusPolicy(Qt::NoFocus);
 
+    // Heatmap: attribute, colour ramp and range
+    QLabel *labele = new QLabel(tr("Colour by"));
+    QLabel *labelf = new QLabel(tr("Colours"));
+    QLabel *labelg = new QLabel(tr("Range"));
+    heatAttribute = new QComboBox();
+    heatAttribute->addItem(tr("Element type"), -1);
+    for (int i = 0; i < AttributeTable::ColumnCount; ++i)
+        heatAttribute->addItem(AttributeTable::columnName(i), i);
+    heatRamp = new QComboBox();
+    for (int i = 0; i < ColourRamp::PresetCount; ++i)
+        heatRamp->addItem(ColourRamp::name(i), i);
+    heatMin = new QDoubleSpinBox(); heatMin->setRange(-1e6, 1e6); heatMin->setDecimals(2);
+    heatMax = new QDoubleSpinBox(); heatMax->setRange(-1e6, 1e6); heatMax->setDecimals(2);
+    heatAuto = new QCheckBox(tr("Auto")); heatAuto->setFocusPolicy(Qt::NoFocus);
+
     // Reset the checked status of each checkbox
     reset();
 
@@ -115,6 +133,15 @@ Controls::Controls(QWidget *parent) : QWidget(parent)
     layout->addWidget(edit6, 6, 5, Qt::AlignHCenter);
     layout->addWidget(edit7, 7, 5, Qt::AlignHCenter);
 
+    layout->addWidget(labele, 8, 1, Qt::AlignLeft);
+    layout->addWidget(labelf, 9, 1, Qt::AlignLeft);
+    layout->addWidget(labelg, 10, 1, Qt::AlignLeft);
+    layout->addWidget(heatAttribute, 8, 2, 1, 4);
+    layout->addWidget(heatRamp, 9, 2, 1, 4);
+    layout->addWidget(heatMin, 10, 2, 1, 2);
+    layout->addWidget(heatMax, 10, 4, 1, 2);
+    layout->addWidget(heatAuto, 11, 2, 1, 4);
+
     // Connect signals and slots
     connect(view1, SIGNAL(stateChanged(int)), this, SLOT(showLayer1(int)));
     connect(view2, SIGNAL(stateChanged(int)), this, SLOT(showLayer2(int)));
@@ -139,6 +166,12 @@ Controls::Controls(QWidget *parent) : QWidget(parent)
     connect(arrow3, SIGNAL(stateChanged(int)), this, SLOT(arrowsLayer3(int)));
     connect(arrow7, SIGNAL(stateChanged(int)), this, SLOT(arrowsLayer7(int)));
 
+    connect(heatAttribute, SIGNAL(currentIndexChanged(int)), this, SLOT(updateHeatmap()));
+    connect(heatRamp, SIGNAL(currentIndexChanged(int)), this, SLOT(updateHeatmap()));
+    connect(heatMin, SIGNAL(editingFinished()), this, SLOT(updateHeatmap()));
+    connect(heatMax, SIGNAL(editingFinished()), this, SLOT(updateHeatmap()));
+    connect(heatAuto, SIGNAL(toggled(bool)), this, SLOT(updateHeatmap()));
+
     // Set layout in widget
     setLayout(layout);
     setSizePolicy(QSizePolicy::Preferred , QSizePolicy::Fixed );
@@ -209,6 +242,27 @@ void Controls::switchPointLayerState(Model::TreeBranch branch, Model::ElementPro
     }
 }
 
+void Controls::updateHeatmap()
+{
+    int column = heatAttribute->itemData(heatAttribute->currentIndex()).toInt();
+    heatRamp->setEnabled(column >= 0);
+    heatAuto->setEnabled(column >= 0);
+    heatMin->setEnabled(column >= 0 && !heatAuto->isChecked());
+    heatMax->setEnabled(column >= 0 && !heatAuto->isChecked());
+    if (!model) return;
+
+    // With the automatic range, the range spans all the values of the attribute
+    float min = heatMin->value(), max = heatMax->value();
+    if (column >= 0 && heatAuto->isChecked() && model->attributeTable()->range(column, min, max))
+    {
+        heatMin->setValue(min);
+        heatMax->setValue(max);
+    }
+
+    // Redirect the request to the model
+    model->setHeatmap(column, ColourRamp(ColourRamp::Preset(heatRamp->currentIndex())), min, max);
+}
+
 void Controls::reset()
 {
     // Resets all the check boxes to the default values
@@ -234,4 +288,16 @@ void Controls::reset()
     arrow2->setChecked(false);
     arrow3->setChecked(false);
     arrow7->setChecked(false);
+
+    // The heatmap is reset without signals, as the model is replaced right after
+    heatAttribute->blockSignals(true);
+    heatAuto->blockSignals(true);
+    heatAttribute->setCurrentIndex(0);
+    heatAuto->setChecked(true);
+    heatAttribute->blockSignals(false);
+    heatAuto->blockSignals(false);
+    heatRamp->setEnabled(false);
+    heatAuto->setEnabled(false);
+    heatMin->setEnabled(false);
+    heatMax->setEnabled(false);
 }
@@ -26,6 +26,8 @@
 
 #include <QWidget>
 #include <QCheckBox>
+#include <QComboBox>
+#include <QDoubleSpinBox>
 
 class Controls : public QWidget
 {
@@ -65,6 +67,9 @@ private slots:
     void editLayer6(int state) const;
     void editLayer7(int state) const;
 
+    // Applies the heatmap attribute, colour ramp and range to the model
+    void updateHeatmap();
+
 private:
     // CheckBox handlers
     QCheckBox *view1, *view2, *view3, *view4, *view6, *view7;
@@ -72,6 +77,11 @@ private:
     QCheckBox *edit1, *edit2, *edit3, *edit4, *edit6, *edit7;
     QCheckBox *arrow1, *arrow2, *arrow3, *arrow7;
 
+    // Heatmap widgets
+    QComboBox *heatAttribute, *heatRamp;
+    QDoubleSpinBox *heatMin, *heatMax;
+    QCheckBox *heatAuto;
+
     // Changes a property of the Path/Point Elements within a layer
     void switchLayerState(Model::TreeBranch branch, bool subbranch, Model::ElementProperty prop, int state) const;
     void switchPointLayerState(Model::TreeBranch branch, Model::ElementProperty prop, int state) const;
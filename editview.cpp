@@ -87,12 +87,7 @@ void EditView::selectionChanged(QItemSelection on, QItemSelection off)
 
             // If the selected item is item caption, clear all fields
             if (model->isCaption(itemOn))
-            {
-                for (int i = 0; i < field.length(); ++i)
-                    field[i]->hide();
-                for (int i = 0; i < edit.length(); ++i)
-                    edit[i]->hide();
-            }
+                hideFields(0);
             else
             {
                 // Retrieve element from the XML domDocument
@@ -105,16 +100,7 @@ void EditView::selectionChanged(QItemSelection on, QItemSelection off)
                 QList<bool> editable;
 
                 // According to the element type, find the name, the attributese list and which of them can be edited
-                switch (itemOn->type)
-                {
-                    case Item::Edge:        elementName = "edge";       attrList = edgeAttr;    editable = edgeEdit;    break;
-                    case Item::Lane:        elementName = "lane";       attrList = laneAttr;    editable = laneEdit;    break;
-                    case Item::Junction:    elementName = "junction";   attrList = juncAttr;    editable = juncEdit;    break;
-                    case Item::Connection:  elementName = "connection"; attrList = connAttr;    editable = connEdit;    break;
-                    case Item::tlLogic:     elementName = "tlLogic";    attrList = tlLgcAttr;   editable = tlLgcEdit;   break;
-                    case Item::Request:     elementName = "request";    attrList = reqAttr;     editable = reqEdit;     break;
-                    case Item::Phase:       elementName = "phase";      attrList = phaseAttr;   editable = phaseEdit;   break;
-                }
+                attributesOf(itemOn->type, elementName, attrList, editable);
 
                 // Update the field labels and the AttrEdits
                 field[0]->setText("element");
@@ -128,11 +114,100 @@ void EditView::selectionChanged(QItemSelection on, QItemSelection off)
                     edit[i + 1]->setModelAndItem(model, itemOn);
                 }
                 // Hide the fields and AttrEdits that are not needed for the selected item
-                for (int j = i + 1; j < field.length(); ++j)
-                {
-                    field[j]->hide();
-                    edit[j]->hide();
-                }
+                hideFields(i + 1);
+            }
+        }
+}
+
+void EditView::elementSelectionChanged(int count)
+{
+    if (count == 0)
+    {
+        hideFields(0);
+        return;
+    }
+
+    // Attributes shared by all the element types in the selection, editable only if they can be
+    // edited in all of them
+    const QList<Item*> &items = model->selectedElements();
+    QSet<int> types;
+    for (int i = 0; i < items.count(); ++i)
+        types.insert(items[i]->type);
+
+    // A selection of several element types has no element name, so that the editors do not offer
+    // the options of one type; it is only labelled as mixed
+    QString elementName, typeName, label;
+    QStringList attrList, typeAttr;
+    QList<bool> editable, typeEdit;
+    QSet<int>::const_iterator type;
+    for (type = types.constBegin(); type != types.constEnd(); ++type)
+    {
+        attributesOf(Item::XMLElement(*type), typeName, typeAttr, typeEdit);
+        if (type == types.constBegin())
+        {
+            elementName = label = typeName;
+            attrList = typeAttr;
+            editable = typeEdit;
+            continue;
+        }
+        elementName.clear();
+        label = tr("mixed");
+        for (int i = attrList.count() - 1; i >= 0; --i)
+        {
+            int j = typeAttr.indexOf(attrList[i]);
+            if (j < 0)
+            {
+                attrList.removeAt(i);
+                editable.removeAt(i);
             }
+            else
+                editable[i] = editable[i] && typeEdit[j];
         }
+    }
+
+    // Geometry is edited on the elements themselves, not in bulk
+    for (int i = 0; i < attrList.count(); ++i)
+        if (attrList[i] == "shape" || attrList[i] == "x" || attrList[i] == "y")
+            editable[i] = false;
+
+    // Values over the whole selection, read in one pass
+    QStringList values;
+    QList<bool> mixed;
+    model->selectionAttributes(attrList, values, mixed);
+
+    int i;
+    field[0]->setText("element");
+    field[0]->show();
+    edit[0]->setAttribute("", "", tr("%1 (%2 selected)").arg(label).arg(count), false);
+    for (i = 0; i < attrList.length(); ++i)
+    {
+        field[i + 1]->setText(attrList[i]);
+        field[i + 1]->show();
+        edit[i + 1]->setAttribute(elementName, attrList[i], values[i], editable[i], mixed[i]);
+        edit[i + 1]->setModelAndItem(model, 0);
+    }
+    hideFields(i + 1);
+}
+
+void EditView::attributesOf(Item::XMLElement type, QString &elementName, QStringList &attrList, QList<bool> &editable) const
+{
+    switch (type)
+    {
+        case Item::Edge:        elementName = "edge";       attrList = edgeAttr;    editable = edgeEdit;    break;
+        case Item::Lane:        elementName = "lane";       attrList = laneAttr;    editable = laneEdit;    break;
+        case Item::Junction:    elementName = "junction";   attrList = juncAttr;    editable = juncEdit;    break;
+        case Item::Connection:  elementName = "connection"; attrList = connAttr;    editable = connEdit;    break;
+        case Item::tlLogic:     elementName = "tlLogic";    attrList = tlLgcAttr;   editable = tlLgcEdit;   break;
+        case Item::Request:     elementName = "request";    attrList = reqAttr;     editable = reqEdit;     break;
+        case Item::Phase:       elementName = "phase";      attrList = phaseAttr;   editable = phaseEdit;   break;
+    }
+}
+
+void EditView::hideFields(int first)
+{
+    for (int j = first; j < field.length(); ++j)
+    {
+        field[j]->hide();
+        edit[j]->hide();
+    }
 }
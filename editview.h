@@ -24,6 +24,7 @@
 
 #include "model.h"
 #include "attredit.h"
+#include "item.h"
 
 #include <QWidget>
 #include <QMainWindow>
@@ -46,6 +47,9 @@ private slots:
     // Refreshes the widget with the attributes of the selected item
     void selectionChanged(QItemSelection on, QItemSelection off);
 
+    // Refreshes the widget with the attributes shared by the elements selected in the network view
+    void elementSelectionChanged(int count);
+
 private:
     // Form layour handler
     QFormLayout *layout;
@@ -59,6 +63,12 @@ private:
 
     // Lists of bools to store whether the attributes are editable or not
     QList<bool> edgeEdit, laneEdit, juncEdit, connEdit, tlLgcEdit, reqEdit, phaseEdit;
+
+    // Finds the element name, the attributes and whether they can be edited for an element type
+    void attributesOf(Item::XMLElement type, QString &elementName, QStringList &attrList, QList<bool> &editable) const;
+
+    // Hides the fields and AttrEdits from 'first' on
+    void hideFields(int first);
 };
 
 #endif // EDITVIEW_H
@@ -0,0 +1,302 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#include "exporter.h"
+#include "renderbatch.h"
+
+#include <QGraphicsScene>
+#include <QPainter>
+#include <QImage>
+#include <QFile>
+#include <QFileInfo>
+#include <QtEndian>
+#include <QtConcurrent>
+#include <QSvgGenerator>
+#include <QPdfWriter>
+#include <QPageSize>
+#include <QPageLayout>
+
+#include <zlib.h>
+
+// Writes a PNG file row by row, compressing the image data as it arrives
+class PngWriter
+{
+public:
+    PngWriter() : opened(false) { }
+    ~PngWriter() { if (opened) deflateEnd(&stream); }
+
+    bool open(const QString &fileName, int width, int height)
+    {
+        file.setFileName(fileName);
+        if (!file.open(QIODevice::WriteOnly)) return false;
+
+        // Signature and header: 8 bits per channel, RGB, no interlacing
+        static const char signature[8] = { '\x89', 'P', 'N', 'G', '\r', '\n', '\x1a', '\n' };
+        file.write(signature, 8);
+        QByteArray header(13, 0);
+        qToBigEndian<quint32>(width, reinterpret_cast<uchar *>(header.data()));
+        qToBigEndian<quint32>(height, reinterpret_cast<uchar *>(header.data() + 4));
+        header[8] = 8;
+        header[9] = 2;
+        writeChunk("IHDR", header);
+
+        stream.zalloc = Z_NULL;
+        stream.zfree = Z_NULL;
+        stream.opaque = Z_NULL;
+        if (deflateInit(&stream, 6) != Z_OK) return false;
+        opened = true;
+        buffer.resize(1 << 16);
+        stream.next_out = reinterpret_cast<Bytef *>(buffer.data());
+        stream.avail_out = buffer.size();
+        return true;
+    }
+
+    bool writeRow(const QByteArray &rgb)
+    {
+        // Every row starts with the filter type; 0 means no filter
+        static const char filter = 0;
+        return compress(&filter, 1, Z_NO_FLUSH) && compress(rgb.constData(), rgb.size(), Z_NO_FLUSH);
+    }
+
+    bool close()
+    {
+        bool ok = compress(0, 0, Z_FINISH);
+        if (stream.avail_out < uInt(buffer.size()))
+            writeChunk("IDAT", buffer.left(buffer.size() - stream.avail_out));
+        writeChunk("IEND", QByteArray());
+        deflateEnd(&stream);
+        opened = false;
+        file.close();
+        return ok && file.error() == QFile::NoError;
+    }
+
+private:
+    bool compress(const char *data, int size, int flush)
+    {
+        stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+        stream.avail_in = size;
+        int result;
+        do
+        {
+            result = deflate(&stream, flush);
+            if (result == Z_STREAM_ERROR) return false;
+
+            // Flush full output buffers as IDAT chunks
+            if (stream.avail_out == 0)
+            {
+                writeChunk("IDAT", buffer);
+                stream.next_out = reinterpret_cast<Bytef *>(buffer.data());
+                stream.avail_out = buffer.size();
+            }
+        } while (stream.avail_in > 0 || (flush == Z_FINISH && result != Z_STREAM_END));
+        return true;
+    }
+
+    void writeChunk(const char *type, const QByteArray &data)
+    {
+        uchar word[4];
+        qToBigEndian<quint32>(data.size(), word);
+        file.write(reinterpret_cast<char *>(word), 4);
+        file.write(type, 4);
+        file.write(data);
+        uLong crc = crc32(0L, Z_NULL, 0);
+        crc = crc32(crc, reinterpret_cast<const Bytef *>(type), 4);
+        crc = crc32(crc, reinterpret_cast<const Bytef *>(data.constData()), data.size());
+        qToBigEndian<quint32>(crc, word);
+        file.write(reinterpret_cast<char *>(word), 4);
+    }
+
+    QFile file;
+    z_stream stream;
+    QByteArray buffer;
+    bool opened;
+};
+
+// Image tile of a band, rendered by a worker thread
+struct Tile
+{
+    QRect pixels;
+    QImage image;
+};
+
+// Renders one tile; the batch is only read, so tiles can be painted concurrently
+class TileRenderer
+{
+public:
+    typedef void result_type;
+
+    TileRenderer(const RenderBatch &batch, const QRectF &rect, qreal scale, const QColor &background)
+        : batch(&batch), rect(rect), scale(scale), background(background) { }
+
+    void operator()(Tile &tile) const
+    {
+        tile.image = QImage(tile.pixels.size(), QImage::Format_RGB32);
+        tile.image.fill(background);
+
+        // Scene to tile transform; y is inverted as in the network view
+        QPainter painter(&tile.image);
+        painter.setRenderHint(QPainter::Antialiasing, true);
+        painter.setTransform(QTransform(scale, 0, 0, -scale,
+                                        -rect.left() * scale - tile.pixels.left(),
+                                        rect.bottom() * scale - tile.pixels.top()));
+
+        // Scene area covered by the tile
+        QRectF exposed(rect.left() + tile.pixels.left() / scale, rect.bottom() - (tile.pixels.bottom() + 1) / scale,
+                       tile.pixels.width() / scale, tile.pixels.height() / scale);
+        batch->paint(&painter, exposed);
+    }
+
+private:
+    const RenderBatch *batch;
+    QRectF rect;
+    qreal scale;
+    QColor background;
+};
+
+bool Exporter::exportScene(QGraphicsScene *scene, const QString &fileName, int width, QString *errorMessage)
+{
+    // Take a snapshot of the visible elements with their current style
+    RenderBatch batch;
+    batch.addScene(scene);
+    QRectF rect = batch.boundingRect();
+    QColor background = scene->backgroundBrush().color();
+
+    if (batch.count() == 0 || rect.isEmpty())
+    {
+        if (errorMessage) *errorMessage = QObject::tr("There are no visible elements to export.");
+        return false;
+    }
+
+    QString suffix = QFileInfo(fileName).suffix().toLower();
+    if (suffix == "svg")
+        return exportSVG(batch, rect, background, fileName, width, errorMessage);
+    if (suffix == "pdf")
+        return exportPDF(batch, rect, background, fileName, errorMessage);
+    return exportPNG(batch, rect, background, fileName, width, errorMessage);
+}
+
+bool Exporter::exportPNG(const RenderBatch &batch, const QRectF &rect, const QColor &background,
+                         const QString &fileName, int width, QString *errorMessage)
+{
+    qreal scale = width / rect.width();
+    int height = qMax(1, qRound(rect.height() * scale));
+
+    PngWriter png;
+    if (!png.open(fileName, width, height))
+    {
+        if (errorMessage) *errorMessage = QObject::tr("Cannot write file %1.").arg(fileName);
+        return false;
+    }
+
+    QByteArray row(width * 3, 0);
+    for (int top = 0; top < height; top += tileSize)
+    {
+        // Render a band of tiles in parallel
+        int bandHeight = qMin(tileSize, height - top);
+        QVector<Tile> tiles;
+        for (int left = 0; left < width; left += tileSize)
+        {
+            Tile tile;
+            tile.pixels = QRect(left, top, qMin(tileSize, width - left), bandHeight);
+            tiles.append(tile);
+        }
+        QtConcurrent::blockingMap(tiles, TileRenderer(batch, rect, scale, background));
+
+        // Stream the band into the file row by row
+        for (int y = 0; y < bandHeight; ++y)
+        {
+            char *out = row.data();
+            for (int t = 0; t < tiles.count(); ++t)
+            {
+                const QRgb *in = reinterpret_cast<const QRgb *>(tiles[t].image.constScanLine(y));
+                for (int x = 0; x < tiles[t].pixels.width(); ++x)
+                {
+                    *out++ = qRed(in[x]);
+                    *out++ = qGreen(in[x]);
+                    *out++ = qBlue(in[x]);
+                }
+            }
+            if (!png.writeRow(row))
+            {
+                if (errorMessage) *errorMessage = QObject::tr("Error compressing image data.");
+                return false;
+            }
+        }
+    }
+
+    if (!png.close())
+    {
+        if (errorMessage) *errorMessage = QObject::tr("Error writing file %1.").arg(fileName);
+        return false;
+    }
+    return true;
+}
+
+bool Exporter::exportSVG(const RenderBatch &batch, const QRectF &rect, const QColor &background,
+                         const QString &fileName, int width, QString *errorMessage)
+{
+    qreal scale = width / rect.width();
+    QSize size(width, qMax(1, qRound(rect.height() * scale)));
+
+    QSvgGenerator generator;
+    generator.setFileName(fileName);
+    generator.setSize(size);
+    generator.setViewBox(QRect(QPoint(0, 0), size));
+    generator.setTitle(QFileInfo(fileName).completeBaseName());
+
+    QPainter painter;
+    if (!painter.begin(&generator))
+    {
+        if (errorMessage) *errorMessage = QObject::tr("Cannot write file %1.").arg(fileName);
+        return false;
+    }
+    painter.fillRect(QRect(QPoint(0, 0), size), background);
+    painter.setTransform(QTransform(scale, 0, 0, -scale, -rect.left() * scale, rect.bottom() * scale));
+    batch.paint(&painter, rect);
+    painter.end();
+    return true;
+}
+
+bool Exporter::exportPDF(const RenderBatch &batch, const QRectF &rect, const QColor &background,
+                         const QString &fileName, QString *errorMessage)
+{
+    // One page with the aspect ratio of the network; the longest side is one metre
+    qreal longest = qMax(rect.width(), rect.height());
+    QSizeF pageSize(1000 * rect.width() / longest, 1000 * rect.height() / longest);
+
+    QPdfWriter writer(fileName);
+    writer.setPageSize(QPageSize(pageSize, QPageSize::Millimeter));
+    writer.setPageMargins(QMarginsF(0, 0, 0, 0));
+    writer.setTitle(QFileInfo(fileName).completeBaseName());
+
+    QPainter painter;
+    if (!painter.begin(&writer))
+    {
+        if (errorMessage) *errorMessage = QObject::tr("Cannot write file %1.").arg(fileName);
+        return false;
+    }
+    qreal scale = writer.width() / rect.width();
+    painter.fillRect(QRect(0, 0, writer.width(), writer.height()), background);
+    painter.setTransform(QTransform(scale, 0, 0, -scale, -rect.left() * scale, rect.bottom() * scale));
+    batch.paint(&painter, rect);
+    painter.end();
+    return true;
+}
@@ -0,0 +1,59 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#include <QString>
+#include <QRectF>
+#include <QColor>
+
+QT_BEGIN_NAMESPACE
+class QGraphicsScene;
+QT_END_NAMESPACE
+
+class RenderBatch;
+
+class Exporter
+{
+public:
+    // Renders the visible elements of the scene into a PNG, SVG or PDF file, chosen by the file extension
+    // 'width' is the image width in pixels; the height follows the aspect ratio of the network
+    // Returns false and fills in 'errorMessage' if the file could not be written
+    static bool exportScene(QGraphicsScene *scene, const QString &fileName, int width, QString *errorMessage = 0);
+
+    // Side of the square tiles rendered in parallel for raster images, in pixels
+    static const int tileSize = 512;
+
+private:
+    // Raster export: renders bands of tiles on all cores and streams the rows into the PNG file,
+    // so memory is bounded by one band whatever the image size
+    static bool exportPNG(const RenderBatch &batch, const QRectF &rect, const QColor &background,
+                          const QString &fileName, int width, QString *errorMessage);
+
+    // Vector export through QSvgGenerator and QPdfWriter
+    static bool exportSVG(const RenderBatch &batch, const QRectF &rect, const QColor &background,
+                          const QString &fileName, int width, QString *errorMessage);
+    static bool exportPDF(const RenderBatch &batch, const QRectF &rect, const QColor &background,
+                          const QString &fileName, QString *errorMessage);
+};
+
+#endif // EXPORTER_H
@@ -117,6 +117,18 @@ void Item::removeChild(Item *item)
     }
 }
 
+void Item::removeChildren(const QSet<Item*> &items)
+{
+    // Remove many children in one pass, e.g. when deleting a selection
+    QList<Item*> kept;
+    for (int i = 0; i < childItems.count(); ++i)
+        if (items.contains(childItems[i]))
+            references.remove(childItems[i]->name, childItems[i]);
+        else
+            kept.append(childItems[i]);
+    childItems = kept;
+}
+
 int Item::row() const
 {
     // Implementation required by QAbstractItemModel
@@ -27,6 +27,7 @@
 
 #include <QList>
 #include <QMultiHash>
+#include <QSet>
 #include <QDomNode>
 
 class Item
@@ -47,6 +48,7 @@ public:
     Item *parent() const;
     int appendChild(Item *item);
     void removeChild(Item *item);
+    void removeChildren(const QSet<Item*> &items);
     int childCount() const;
     int row() const;
 
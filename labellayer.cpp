@@ -0,0 +1,304 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#include "labellayer.h"
+#include "model.h"
+
+#include <QPainter>
+#include <QFontMetricsF>
+#include <QtConcurrentMap>
+#include <qmath.h>
+#include <QtAlgorithms>
+
+// Label waiting to be placed in a tile
+struct LabelCandidate
+{
+    int source;
+    QRectF rect;
+    int kind;
+    float extent;
+
+    // The label is anchored in the tile being placed, rather than in a neighbouring one
+    bool own;
+};
+
+// Traffic light labels are placed first, then junctions, then edges from the longest; ties are
+// broken by the source index, so that neighbouring tiles place the labels they share in the same order
+static bool placedBefore(const LabelCandidate &a, const LabelCandidate &b)
+{
+    if (a.kind != b.kind) return a.kind > b.kind;
+    if (a.extent != b.extent) return a.extent > b.extent;
+    return a.source < b.source;
+}
+
+LabelLayer::LabelLayer(QObject *parent) : QObject(parent)
+{
+    // Initialise members
+    model = 0;
+    tileScale = 0;
+    generation = 0;
+    for (int i = 0; i < LabelSource::KindCount; ++i)
+        kinds[i] = false;
+    font.setPointSize(8);
+    glyphs.setMaxCost(4000);
+
+    reloadTimer.setSingleShot(true);
+    reloadTimer.setInterval(500);
+    connect(&reloadTimer, SIGNAL(timeout()), this, SLOT(reload()));
+    connect(&watcher, SIGNAL(resultReadyAt(int)), this, SLOT(tilePlaced(int)));
+    connect(&watcher, SIGNAL(finished()), this, SLOT(placeNext()));
+}
+
+void LabelLayer::setModel(Model *model)
+{
+    // Follow the geometry changes of the new model instead of the old one, if it still exists
+    if (this->model) disconnect(this->model, 0, &reloadTimer, 0);
+    this->model = model;
+    connect(model, SIGNAL(geometryChanged(QRectF)), &reloadTimer, SLOT(start()));
+    reload();
+}
+
+void LabelLayer::reload()
+{
+    if (!model) return;
+
+    // Collect the labels and sort them into the grid cells
+    Index *newIndex = new Index;
+    model->labelSources(newIndex->sources);
+    newIndex->cellSize = cellSize;
+    for (int i = 0; i < newIndex->sources.count(); ++i)
+    {
+        const QPointF &anchor = newIndex->sources[i].anchor;
+        newIndex->cells[key(qFloor(anchor.x() / cellSize), qFloor(anchor.y() / cellSize))].append(i);
+    }
+    index = QSharedPointer<const Index>(newIndex);
+
+    // The label indices changed, so the text layouts are created again
+    glyphs.clear();
+    invalidate();
+}
+
+void LabelLayer::invalidate()
+{
+    ++generation;
+    tiles.clear();
+    requested.clear();
+    queued.clear();
+    emit updateNeeded();
+}
+
+void LabelLayer::showEdgeLabels(bool show)
+{
+    kinds[LabelSource::EdgeLabel] = show;
+    invalidate();
+}
+
+void LabelLayer::showJunctionLabels(bool show)
+{
+    kinds[LabelSource::JunctionLabel] = show;
+    invalidate();
+}
+
+void LabelLayer::showTLLabels(bool show)
+{
+    kinds[LabelSource::TLLabel] = show;
+    invalidate();
+}
+
+bool LabelLayer::isEnabled() const
+{
+    for (int i = 0; i < LabelSource::KindCount; ++i)
+        if (kinds[i]) return true;
+    return false;
+}
+
+void LabelLayer::paint(QPainter *painter, const QTransform &transform, const QRect &viewport)
+{
+    if (!isEnabled() || index.isNull()) return;
+
+    // Placements depend on the scale; the view scales both axes by the same amount
+    qreal scale = transform.m11();
+    if (scale != tileScale)
+    {
+        tileScale = scale;
+        invalidate();
+    }
+    if (tiles.count() > maxTiles) invalidate();
+
+    // Network pixels plus this offset are viewport pixels
+    QPointF offset(transform.dx(), transform.dy());
+    QRectF visible = QRectF(viewport).translated(-offset);
+    int x0 = qFloor(visible.left() / tileSize), x1 = qFloor(visible.right() / tileSize);
+    int y0 = qFloor(visible.top() / tileSize), y1 = qFloor(visible.bottom() / tileSize);
+
+    // Labels belong to the tile holding their anchor and may cross into the next one, so the
+    // tiles around the visible ones are painted too
+    --x0; ++x1; --y0; ++y1;
+
+    // Paint in viewport pixels, so that the labels keep their size whatever the zoom
+    painter->save();
+    painter->resetTransform();
+    painter->setFont(font);
+    QColor colours[LabelSource::KindCount] = { Qt::black, QColor(0, 100, 0), QColor(160, 0, 0) };
+    bool missing = false;
+    for (int y = y0; y <= y1; ++y)
+        for (int x = x0; x <= x1; ++x)
+        {
+            qint64 k = key(x, y);
+            QHash<qint64, QVector<Placed> >::const_iterator tile = tiles.constFind(k);
+            if (tile == tiles.constEnd())
+            {
+                // Request the tile once; it is painted when the worker threads have placed it
+                if (!requested.contains(k))
+                {
+                    requested.insert(k);
+                    queued.append(k);
+                    missing = true;
+                }
+                continue;
+            }
+            for (int i = 0; i < tile->count(); ++i)
+            {
+                const Placed &label = tile->at(i);
+                QRectF rect = label.rect.translated(offset);
+                painter->fillRect(rect, QColor(255, 255, 255, 190));
+                painter->setPen(colours[index->sources[label.source].kind]);
+                painter->drawStaticText(rect.topLeft() + QPointF(3, 1), *glyphsOf(label.source));
+            }
+        }
+    painter->restore();
+
+    if (missing) placeNext();
+}
+
+void LabelLayer::placeNext()
+{
+    // Tiles are placed in batches, one batch at a time
+    if (watcher.isRunning() || queued.isEmpty() || index.isNull()) return;
+
+    Placer placer;
+    placer.index = index;
+    placer.scale = tileScale;
+    placer.font = font;
+    for (int i = 0; i < LabelSource::KindCount; ++i)
+        placer.kinds[i] = kinds[i];
+    placer.generation = generation;
+
+    QList<qint64> batch = queued;
+    queued.clear();
+    watcher.setFuture(QtConcurrent::mapped(batch, placer));
+}
+
+void LabelLayer::tilePlaced(int i)
+{
+    Tile tile = watcher.resultAt(i);
+    if (tile.generation != generation) return;
+    tiles.insert(tile.key, tile.labels);
+    emit updateNeeded();
+}
+
+const QStaticText *LabelLayer::glyphsOf(int source)
+{
+    QStaticText *text = glyphs.object(source);
+    if (!text)
+    {
+        text = new QStaticText(index->sources[source].text);
+        text->setTextFormat(Qt::PlainText);
+        text->setPerformanceHint(QStaticText::AggressiveCaching);
+        text->prepare(QTransform(), font);
+        glyphs.insert(source, text);
+    }
+    return text;
+}
+
+qint64 LabelLayer::key(int x, int y)
+{
+    return (qint64(x) << 32) | quint32(y);
+}
+
+LabelLayer::Tile LabelLayer::Placer::operator()(qint64 tileKey) const
+{
+    Tile tile;
+    tile.key = tileKey;
+    tile.generation = generation;
+
+    // Nothing is labelled below the scale of traffic light labels
+    if (scale < 0.3) return tile;
+
+    // Area of the tile in network pixels and in scene coordinates
+    int tx = int(tileKey >> 32), ty = int(qint32(tileKey & 0xffffffff));
+    QRectF pixels(tx * tileSize, ty * tileSize, tileSize, tileSize);
+    QRectF area(pixels.left() / scale, -pixels.bottom() / scale, tileSize / scale, tileSize / scale);
+    QFontMetricsF metrics(font);
+
+    // Collect the labels visible at this scale that are anchored in the tile, or anchored in a
+    // neighbouring tile and reaching into this one; a label crossing the border belongs to the tile
+    // of its anchor, and the labels of the neighbours only keep this tile from overlapping them
+    QVector<LabelCandidate> candidates;
+    qreal margin = tileSize / scale;
+    QRectF around = area.adjusted(-margin, -margin, margin, margin);
+    int cx0 = qFloor(around.left() / index->cellSize), cx1 = qFloor(around.right() / index->cellSize);
+    int cy0 = qFloor(around.top() / index->cellSize), cy1 = qFloor(around.bottom() / index->cellSize);
+    for (int cy = cy0; cy <= cy1; ++cy)
+        for (int cx = cx0; cx <= cx1; ++cx)
+        {
+            QHash<qint64, QVector<int> >::const_iterator cell = index->cells.constFind(key(cx, cy));
+            if (cell == index->cells.constEnd()) continue;
+            for (int i = 0; i < cell->count(); ++i)
+            {
+                const LabelSource &source = index->sources[cell->at(i)];
+                if (!kinds[source.kind] || !around.contains(source.anchor)) continue;
+                if (source.kind == LabelSource::JunctionLabel && scale < 1.0) continue;
+
+                QSizeF size(metrics.width(source.text) + 6, metrics.height() + 2);
+                if (source.kind == LabelSource::EdgeLabel && source.extent * scale < size.width() + 20) continue;
+
+                // Centered on the anchor; traffic light labels go below the junction label
+                QPointF centre(source.anchor.x() * scale, -source.anchor.y() * scale);
+                bool own = (qFloor(centre.x() / tileSize) == tx && qFloor(centre.y() / tileSize) == ty);
+                if (source.kind == LabelSource::TLLabel) centre.ry() += size.height();
+                QRectF rect(centre - QPointF(size.width() / 2, size.height() / 2), size);
+                if (!own && !rect.intersects(pixels)) continue;
+
+                LabelCandidate candidate = { cell->at(i), rect, source.kind, source.extent, own };
+                candidates.append(candidate);
+            }
+        }
+
+    // Place the most important labels first, skipping any label overlapping one already placed;
+    // only the labels anchored in the tile are kept
+    qSort(candidates.begin(), candidates.end(), placedBefore);
+    QVector<QRectF> taken;
+    for (int i = 0; i < candidates.count(); ++i)
+    {
+        bool overlaps = false;
+        for (int j = 0; j < taken.count() && !overlaps; ++j)
+            overlaps = taken[j].intersects(candidates[i].rect);
+        if (overlaps) continue;
+        taken.append(candidates[i].rect);
+        if (candidates[i].own)
+        {
+            Placed placed = { candidates[i].source, candidates[i].rect };
+            tile.labels.append(placed);
+        }
+    }
+    return tile;
+}
@@ -0,0 +1,175 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#ifndef LABELLAYER_H
+#define LABELLAYER_H
+
+#include <QObject>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QCache>
+#include <QFont>
+#include <QRectF>
+#include <QTimer>
+#include <QStaticText>
+#include <QSharedPointer>
+#include <QFutureWatcher>
+#include <QPointer>
+
+class Model;
+
+QT_BEGIN_NAMESPACE
+class QPainter;
+QT_END_NAMESPACE
+
+// Element id to be labelled at a point of the network
+struct LabelSource
+{
+    // Kinds of labels, from the least to the most important
+    enum Kind { EdgeLabel, JunctionLabel, TLLabel, KindCount };
+
+    QString text;
+    QPointF anchor;
+    int kind;
+
+    // Length of the edge in metres, so that edge labels only appear once they fit along the edge; 0 otherwise
+    float extent;
+};
+
+class LabelLayer : public QObject
+{
+    Q_OBJECT
+public:
+    // Constructor
+    explicit LabelLayer(QObject *parent = 0);
+
+    // Shows the ids of the elements of a model, following its geometry changes
+    void setModel(Model *model);
+
+    // Paints the labels of the visible tiles over a view; 'transform' maps the scene into the viewport
+    // Tiles without a placement yet are requested to the worker threads and painted when ready
+    void paint(QPainter *painter, const QTransform &transform, const QRect &viewport);
+
+public slots:
+    // Switch each kind of label on or off
+    void showEdgeLabels(bool show);
+    void showJunctionLabels(bool show);
+    void showTLLabels(bool show);
+
+signals:
+    // Emitted when newly placed tiles can be painted
+    void updateNeeded();
+
+private slots:
+    // Collects the labels of the model again after an edit
+    void reload();
+
+    // Stores a placed tile
+    void tilePlaced(int index);
+
+    // Starts placing the tiles requested meanwhile
+    void placeNext();
+
+private:
+    // Labels and a grid of the label indices per cell, shared read only with the worker threads
+    struct Index
+    {
+        QVector<LabelSource> sources;
+        QHash<qint64, QVector<int> > cells;
+        qreal cellSize;
+    };
+
+    // Placed label: source index and rectangle in network pixels (scene coordinates multiplied by
+    // the scale, with the y axis pointing downwards)
+    struct Placed
+    {
+        int source;
+        QRectF rect;
+    };
+
+    // Labels placed in a tile
+    struct Tile
+    {
+        qint64 key;
+        int generation;
+        QVector<Placed> labels;
+    };
+
+    // Places the labels of a tile; runs in a worker thread
+    struct Placer
+    {
+        typedef Tile result_type;
+        QSharedPointer<const Index> index;
+        qreal scale;
+        QFont font;
+        bool kinds[LabelSource::KindCount];
+        int generation;
+        Tile operator()(qint64 key) const;
+    };
+
+    // Tile size in pixels, and number of placed tiles kept before the cache is emptied
+    static const int tileSize = 256;
+    static const int maxTiles = 1024;
+
+    // Size in metres of the cells of the label grid
+    static const int cellSize = 100;
+
+    // Model and its labels
+    QPointer<Model> model;
+    QSharedPointer<const Index> index;
+
+    // Placed tiles, tiles being placed, and tiles waiting for the next batch
+    QHash<qint64, QVector<Placed> > tiles;
+    QSet<qint64> requested;
+    QList<qint64> queued;
+    QFutureWatcher<Tile> watcher;
+
+    // Scale the tiles were placed for; changing the labels, the scale or the visible kinds
+    // increments the generation, so that tiles still being placed are discarded
+    qreal tileScale;
+    int generation;
+
+    // Visible kinds of labels
+    bool kinds[LabelSource::KindCount];
+
+    // Font and text layout cache per label
+    QFont font;
+    QCache<int, QStaticText> glyphs;
+
+    // Groups the geometry changes of an edit before collecting the labels again
+    QTimer reloadTimer;
+
+    // Drops all placed tiles
+    void invalidate();
+
+    // Returns true if any kind of label is visible
+    bool isEnabled() const;
+
+    // Returns the text layout of a label, creating it if needed
+    const QStaticText *glyphsOf(int source);
+
+    // Key of a tile from its column and row
+    static qint64 key(int x, int y);
+};
+
+#endif // LABELLAYER_H
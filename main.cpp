@@ -20,14 +20,107 @@
 
 
 #include "mainwindow.h"
+#include "model.h"
+#include "exporter.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QItemSelectionModel>
+#include <QTextStream>
+#include <QFile>
+
+// Loads a network and exports it to an image file without opening the main window
+static int exportNetwork(const QString &netPath, const QString &imagePath, int width, const QStringList &hiddenLayers)
+{
+    QTextStream err(stderr);
+
+    QFile file(netPath);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        err << QObject::tr("Cannot open %1.").arg(netPath) << "\n";
+        return 1;
+    }
+
+    Model model(&file);
+    file.close();
+    if (!model.xmlDataParsed())
+    {
+        err << QObject::tr("Error parsing XML data.") << "\n";
+        return 1;
+    }
+    QItemSelectionModel selections(&model);
+    model.setSelectionModel(&selections);
+    model.loadModel();
+
+    // Hide the requested layers, as the checkboxes of the Controls view do
+    if (hiddenLayers.contains("edges"))
+    {
+        model.switchLayerState(Model::NEdgesBranch, false, Model::ViewElement, false);
+        model.switchLayerState(Model::IEdgesBranch, false, Model::ViewElement, false);
+    }
+    if (hiddenLayers.contains("lanes"))
+        model.switchLayerState(Model::NEdgesBranch, true, Model::ViewElement, false);
+    if (hiddenLayers.contains("intlanes"))
+        model.switchLayerState(Model::IEdgesBranch, true, Model::ViewElement, false);
+    if (hiddenLayers.contains("junctions"))
+    {
+        model.switchLayerState(Model::PJuncsBranch, false, Model::ViewElement, false);
+        model.switchPointLayerState(Model::PJuncsBranch, Model::ViewElement, false);
+    }
+    if (hiddenLayers.contains("intjunctions"))
+        model.switchPointLayerState(Model::IJuncsBranch, Model::ViewElement, false);
+    if (hiddenLayers.contains("connections"))
+    {
+        model.switchLayerState(Model::ConnsBranch, false, Model::ViewElement, false);
+        model.switchPointLayerState(Model::ConnsBranch, Model::ViewElement, false);
+    }
+
+    QString error;
+    if (!Exporter::exportScene(model.netScene, imagePath, width, &error))
+    {
+        err << error << "\n";
+        return 1;
+    }
+    return 0;
+}
 
 int main(int argc, char *argv[])
 {
     Q_INIT_RESOURCE(vres);
 
+    // Exporting does not need a display, so use the offscreen platform unless another one was requested
+    bool exporting = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        QString arg(argv[i]);
+        if (arg == "--export" || arg.startsWith("--export=")) exporting = true;
+    }
+    if (exporting && qgetenv("QT_QPA_PLATFORM").isEmpty())
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
     QApplication app(argc, argv);
+
+    if (exporting)
+    {
+        QCommandLineParser parser;
+        parser.setApplicationDescription(QObject::tr("Network Editor for SUMO"));
+        parser.addHelpOption();
+        QCommandLineOption exportOption("export", QObject::tr("Export the network to a PNG, SVG or PDF <file> and exit."), "file");
+        QCommandLineOption widthOption("width", QObject::tr("Image width in <pixels> (default 4000)."), "pixels", "4000");
+        QCommandLineOption hideOption("hide", QObject::tr("Comma separated <layers> to hide: edges, lanes, intlanes, junctions, intjunctions, connections."), "layers");
+        parser.addOption(exportOption);
+        parser.addOption(widthOption);
+        parser.addOption(hideOption);
+        parser.addPositionalArgument("network", QObject::tr("SUMO network file (*.net.xml)."));
+        parser.process(app);
+
+        if (parser.positionalArguments().isEmpty())
+            parser.showHelp(1);
+
+        return exportNetwork(parser.positionalArguments().first(), parser.value(exportOption),
+                             qMax(1, parser.value(widthOption).toInt()), parser.value(hideOption).split(","));
+    }
+
     MainWindow window;
     window.showMaximized();
     return app.exec();
@@ -24,6 +24,8 @@
 #include "item.h"
 #include "jcteditor.h"
 #include "tleditor.h"
+#include "exporter.h"
+#include "transformdialog.h"
 
 #include <QMenuBar>
 #include <QStatusBar>
@@ -32,6 +34,8 @@
 #include <QFileDialog>
 #include <QTextStream>
 #include <QMessageBox>
+#include <QInputDialog>
+#include <QApplication>
 #include <QCoreApplication>
 #include <QTime>
 #include <QProcess>
@@ -88,7 +92,7 @@
  v0.5
  * delete element
  * add/delete phases (tl)
- * duplicate element!!
+ * duplicate element!!      OK
  * connectors update??
  * searchXML
  * interpret other files
@@ -134,10 +138,27 @@ MainWindow::MainWindow() : QMainWindow()
     addDockWidget(Qt::RightDockWidgetArea, editWidget);
     editWidget->hide();
 
+    // Create overview minimap
+    miniMap = new MiniMap(nView);
+    miniMapWidget = new QDockWidget(tr("Overview"), this);
+    miniMapWidget->setWidget(miniMap);
+    addDockWidget(Qt::RightDockWidgetArea, miniMapWidget);
+    miniMapWidget->hide();
+    connect(nView, SIGNAL(visibleAreaChanged(QRectF)), miniMap, SLOT(setVisibleArea(QRectF)));
+
+    // Create element search
+    searchView = new SearchView(this);
+    searchWidget = new QDockWidget(tr("Search"), this);
+    searchWidget->setWidget(searchView);
+    addDockWidget(Qt::LeftDockWidgetArea, searchWidget);
+    searchWidget->hide();
+    connect(searchView, SIGNAL(itemPicked(Item*)), this, SLOT(showSearchResult(Item*)));
+
     // Create menu
     fileMenu = menuBar()->addMenu(tr("&File"));
     fileMenu->addAction(tr("&Open..."), this, SLOT(openFile()), QKeySequence::Open);
     fileMenu->addAction(tr("Save &As..."), this, SLOT(saveAsFile()), QKeySequence::Save/*As*/);
+    fileMenu->addAction(tr("&Export Image..."), this, SLOT(exportImage()));
     fileMenu->addSeparator();
     fileMenu->addAction(tr("Open in SUMO-GUI"), this, SLOT(openSUMO()));
     fileMenu->addAction(tr("Locate SUMO-GUI..."), this, SLOT(locateSUMO()));
@@ -149,17 +170,57 @@ MainWindow::MainWindow() : QMainWindow()
     viewMenu->addAction(controlWidget->toggleViewAction());
     viewMenu->addAction(propsWidget->toggleViewAction());
     viewMenu->addAction(editWidget->toggleViewAction());
+    viewMenu->addAction(miniMapWidget->toggleViewAction());
+    viewMenu->addAction(searchWidget->toggleViewAction());
+    viewMenu->addAction(tr("&Find Element..."), this, SLOT(findElement()), QKeySequence::Find);
+    viewMenu->addSeparator();
+    QMenu *labelsMenu = viewMenu->addMenu(tr("&Labels"));
+    QAction *edgeLabelsAction = labelsMenu->addAction(tr("&Edge IDs"));
+    edgeLabelsAction->setCheckable(true);
+    connect(edgeLabelsAction, SIGNAL(toggled(bool)), nView->labelLayer(), SLOT(showEdgeLabels(bool)));
+    QAction *juncLabelsAction = labelsMenu->addAction(tr("&Junction IDs"));
+    juncLabelsAction->setCheckable(true);
+    connect(juncLabelsAction, SIGNAL(toggled(bool)), nView->labelLayer(), SLOT(showJunctionLabels(bool)));
+    QAction *tlLabelsAction = labelsMenu->addAction(tr("&Traffic Light IDs"));
+    tlLabelsAction->setCheckable(true);
+    connect(tlLabelsAction, SIGNAL(toggled(bool)), nView->labelLayer(), SLOT(showTLLabels(bool)));
+    viewMenu->addSeparator();
+    QAction *statsAction = viewMenu->addAction(tr("Rendering &Statistics"));
+    statsAction->setCheckable(true);
+    statsAction->setShortcut(QKeySequence(Qt::Key_F12));
+    connect(statsAction, SIGNAL(toggled(bool)), nView, SLOT(showStats(bool)));
+    logStatsAction = viewMenu->addAction(tr("&Log Rendering Statistics..."));
+    logStatsAction->setCheckable(true);
+    logStatsAction->setShortcut(QKeySequence(Qt::SHIFT + Qt::Key_F12));
+    connect(logStatsAction, SIGNAL(toggled(bool)), this, SLOT(logRenderStats(bool)));
+
+    selectionMenu = menuBar()->addMenu(tr("Se&lection"));
+    selectionMenu->addAction(tr("&Delete Elements"), this, SLOT(deleteSelection()), QKeySequence(Qt::SHIFT + Qt::Key_Delete));
+    selectionMenu->addAction(tr("Set &Attribute..."), this, SLOT(setSelectionAttribute()));
+    selectionMenu->addAction(tr("&Show/Hide Elements"), this, SLOT(toggleSelectionVisibility()), QKeySequence(Qt::CTRL + Qt::Key_H));
+    selectionMenu->addAction(tr("&Export Elements..."), this, SLOT(exportSelection()));
+    selectionMenu->addSeparator();
+    selectionMenu->addAction(tr("C&opy Elements"), this, SLOT(copySelection()), QKeySequence::Copy);
+    selectionMenu->addAction(tr("&Paste Elements"), this, SLOT(pasteSelection()), QKeySequence::Paste);
+    selectionMenu->addAction(tr("D&uplicate Elements"), this, SLOT(duplicateSelection()), QKeySequence(Qt::CTRL + Qt::Key_D));
+    selectionMenu->addAction(tr("&Transform Elements..."), this, SLOT(transformSelection()), QKeySequence(Qt::CTRL + Qt::Key_T));
+    selectionMenu->addSeparator();
+    selectionMenu->addAction(tr("Select by &Query..."), this, SLOT(selectByQuery()), QKeySequence(Qt::CTRL + Qt::SHIFT + Qt::Key_F));
+    selectionMenu->addAction(tr("&Clear Selection"), this, SLOT(clearSelection()));
 
     specialEditorsMenu = menuBar()->addMenu(tr("&Special Editors"));
     nmlJuncIcon = QPixmap(":/icons/nmlJunc1616.png");
     tlLogicIcon = QPixmap(":/icons/tllogic1616.png");
     specialEditorsMenu->addAction(nmlJuncIcon, tr("&Junction Editor"), this, SLOT(openJunctionEditor()));
     specialEditorsMenu->addAction(tlLogicIcon, tr("&tlLogic Editor"), this, SLOT(openTLEditor()));
+    specialEditorsMenu->addSeparator();
+    specialEditorsMenu->addAction(tr("Recompute Lane &Lengths..."), this, SLOT(recomputeLengths()));
 
     // Read settings from the nefs.ini file
     QSettings settings(QCoreApplication::applicationDirPath() + "/nefs.ini", QSettings::IniFormat);
     xmlPath = settings.value("paths/work").toString();
     sumoguiPath = settings.value("paths/sumo").toString();
+    exportWidth = settings.value("export/width", 8000).toInt();
 
     // Status bar
     statusBar()->showMessage(tr("Ready"));
@@ -169,6 +230,8 @@ MainWindow::MainWindow() : QMainWindow()
     setWindowIcon(QIcon(QPixmap(":/icons/NE4S128.png")));
 
     modelLoaded = false;
+    pasteCount = 0;
+    lengthTolerance = 0.1;
 }
 
 void MainWindow::openFile()
@@ -211,6 +274,7 @@ void MainWindow::openFile()
                     // individual graphic elements as they are created
                     treeSelections = new QItemSelectionModel(newModel);
                     newModel->setSelectionModel(treeSelections);
+                    newModel->setAnimator(nView->animator());
 
                     // Interpret XML tree and create the traffic network elements
                     newModel->loadModel();
@@ -223,18 +287,23 @@ void MainWindow::openFile()
 
                     // Connect model with network view
                     nView->setScene(newModel->netScene);
+                    nView->invalidateBackground(QRectF());
+                    connect(newModel, SIGNAL(geometryChanged(QRectF)), nView, SLOT(invalidateBackground(QRectF)));
                     nView->setSelectionModel(treeSelections);
                     nView->zoomExtents();
-                    nView->setRenderHint(QPainter::Antialiasing, true);
 
                     // Connect model with controls and properties view
                     controls->reset();
                     controls->model = newModel;
                     pView->model = newModel;
                     eView->model = newModel;
+                    miniMap->setModel(newModel);
+                    nView->labelLayer()->setModel(newModel);
+                    searchView->setModel(newModel);
                     controlWidget->show();
                     propsWidget->show();
                     editWidget->show();
+                    miniMapWidget->show();
 
                     // Replace old model by new model
                     model = newModel;
@@ -255,6 +324,9 @@ void MainWindow::openFile()
                     connect(treeSelections, SIGNAL(selectionChanged(QItemSelection, QItemSelection)), this, SLOT(scrollTo(QItemSelection, QItemSelection)));
                     connect(model, SIGNAL(attrUpdate(QItemSelection, QItemSelection)), pView, SLOT(selectionChanged(QItemSelection, QItemSelection)));
                     connect(model, SIGNAL(attrUpdate(QItemSelection, QItemSelection)), eView, SLOT(selectionChanged(QItemSelection, QItemSelection)));
+                    connect(nView, SIGNAL(elementsSelected(QList<Item*>)), model, SLOT(selectElements(QList<Item*>)));
+                    connect(model, SIGNAL(elementSelectionChanged(int)), this, SLOT(showSelectionCount(int)));
+                    connect(model, SIGNAL(elementSelectionChanged(int)), eView, SLOT(elementSelectionChanged(int)));
                     statusBar()->showMessage(tr("Ready. Model loaded in %1ms.").arg(t.elapsed()));
                 }
                 else
@@ -282,19 +354,18 @@ void MainWindow::saveAsFile()
         // Open file and save model domDocument in it
         if (!filePath.isEmpty())
         {
-            QFile file(filePath);
             statusBar()->showMessage(tr("Saving XML file..."));
-            if (file.open(QIODevice::WriteOnly | QIODevice::Text))
+            QString errorMessage;
+            if (model->saveFile(filePath, &errorMessage))
             {
-                QTextStream textStream(&file);
-                model->saveTo(textStream);
-
                 xmlPath = filePath;
-                QFileInfo fileInfo(file.fileName());
+                QFileInfo fileInfo(filePath);
                 QString filename(fileInfo.fileName());
                 setWindowTitle(filename + tr(" - Network Editor for SUMO"));
             }
-            file.close();
+            else
+                QMessageBox::warning(this, tr("Network Editor for SUMO"),
+                                     tr("Error saving XML file: %1").arg(errorMessage));
             statusBar()->showMessage(tr("Ready"));
         }
     } else {
@@ -302,6 +373,71 @@ void MainWindow::saveAsFile()
     }
 }
 
+void MainWindow::exportImage()
+{
+    if (modelLoaded)
+    {
+        // Get file name from File Dialog; the format is chosen by the extension
+        QString filePath = QFileDialog::getSaveFileName(this, tr("Export network image"),
+            xmlPath.left(xmlPath.lastIndexOf('/')), tr("PNG images (*.png);;SVG images (*.svg);;PDF documents (*.pdf)"));
+        QCoreApplication::processEvents();
+        if (filePath.isEmpty()) return;
+
+        // Raster and SVG images need a width in pixels; PDF pages have a fixed size
+        if (!filePath.endsWith(".pdf", Qt::CaseInsensitive))
+        {
+            bool ok;
+            int width = QInputDialog::getInt(this, tr("Export Image"), tr("Image width in pixels:"), exportWidth, 100, 200000, 1000, &ok);
+            if (!ok) return;
+            exportWidth = width;
+        }
+
+        // Render the visible layers with their current style
+        QTime t;
+        t.start();
+        statusBar()->showMessage(tr("Exporting image..."));
+        QApplication::setOverrideCursor(Qt::WaitCursor);
+        QString error;
+        bool exported = Exporter::exportScene(model->netScene, filePath, exportWidth, &error);
+        QApplication::restoreOverrideCursor();
+
+        if (exported)
+            statusBar()->showMessage(tr("Ready. Image exported in %1ms.").arg(t.elapsed()));
+        else
+        {
+            statusBar()->showMessage(tr("Ready"));
+            QMessageBox::warning(this, tr("Network Editor for SUMO"), error);
+        }
+    } else {
+        QMessageBox::information(this, tr("Export Image..."), tr("No model loaded to export."));
+    }
+}
+
+void MainWindow::logRenderStats(bool on)
+{
+    if (on)
+    {
+        // Ask for the CSV file and start logging one line per frame
+        QString filePath = QFileDialog::getSaveFileName(this, tr("Log rendering statistics"),
+            xmlPath.left(xmlPath.lastIndexOf('/')), tr("CSV files (*.csv)"));
+        if (filePath.isEmpty() || !nView->startStatsLog(filePath))
+        {
+            logStatsAction->blockSignals(true);
+            logStatsAction->setChecked(false);
+            logStatsAction->blockSignals(false);
+            if (!filePath.isEmpty())
+                QMessageBox::warning(this, tr("Network Editor for SUMO"), tr("Cannot write file %1.").arg(filePath));
+            return;
+        }
+        statusBar()->showMessage(tr("Logging rendering statistics to %1").arg(filePath));
+    }
+    else
+    {
+        nView->stopStatsLog();
+        statusBar()->showMessage(tr("Ready"));
+    }
+}
+
 void MainWindow::scrollTo(QItemSelection on, QItemSelection off)
 {
     // Ensure the item is visible in the tree (when clicked in the network view)
@@ -321,6 +457,167 @@ void MainWindow::showItem(QModelIndex index)
         nView->centerOn(item->graphicItem2);
 }
 
+void MainWindow::findElement()
+{
+    if (!modelLoaded) return;
+    searchWidget->show();
+    searchWidget->raise();
+    searchView->activate();
+}
+
+void MainWindow::showSearchResult(Item *item)
+{
+    // Select the item as if it had been clicked in the tree, then show it as when double clicked
+    QModelIndex index = model->index(item);
+    treeSelections->select(index, QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows);
+    showItem(index);
+}
+
+void MainWindow::deleteSelection()
+{
+    if (!modelLoaded || model->selectedElements().isEmpty()) return;
+
+    int count = model->selectedElements().count();
+    if (QMessageBox::question(this, tr("Network Editor for SUMO"), tr("Delete %1 selected elements?").arg(count),
+                              QMessageBox::Yes | QMessageBox::No, QMessageBox::No) == QMessageBox::Yes)
+    {
+        QTime t;
+        t.start();
+        model->deleteSelection();
+        statusBar()->showMessage(tr("%1 elements deleted in %2ms.").arg(count).arg(t.elapsed()));
+    }
+}
+
+void MainWindow::setSelectionAttribute()
+{
+    if (!modelLoaded || model->selectedElements().isEmpty()) return;
+
+    bool ok;
+    QString attr = QInputDialog::getText(this, tr("Set Attribute"), tr("Attribute name:"), QLineEdit::Normal, QString(), &ok).trimmed();
+    if (!ok || attr.isEmpty()) return;
+    QString value = QInputDialog::getText(this, tr("Set Attribute"), tr("Value of '%1' for %2 elements:").arg(attr).arg(model->selectedElements().count()),
+                                          QLineEdit::Normal, QString(), &ok);
+    if (!ok) return;
+
+    QTime t;
+    t.start();
+    model->setSelectionAttribute(attr, value);
+    statusBar()->showMessage(tr("Attribute set in %1ms.").arg(t.elapsed()));
+}
+
+void MainWindow::toggleSelectionVisibility()
+{
+    // Hide the selection if any of it is visible, otherwise show it again
+    if (modelLoaded) model->setSelectionVisible(!model->selectionVisible());
+}
+
+void MainWindow::exportSelection()
+{
+    if (!modelLoaded || model->selectedElements().isEmpty()) return;
+
+    QString filePath = QFileDialog::getSaveFileName(this, tr("Export selected elements"),
+        xmlPath, tr("XML Network files (*.net.xml)"));
+    if (filePath.isEmpty()) return;
+
+    QFile file(filePath);
+    QString errorMessage;
+    if (!file.open(QIODevice::WriteOnly))
+        QMessageBox::warning(this, tr("Export Elements..."), tr("Could not write %1.").arg(filePath));
+    else if (!model->exportSelection(&file, &errorMessage))
+        QMessageBox::warning(this, tr("Export Elements..."), tr("Error exporting elements: %1").arg(errorMessage));
+    else
+        statusBar()->showMessage(tr("Ready"));
+}
+
+void MainWindow::clearSelection()
+{
+    if (modelLoaded) model->clearElementSelection();
+}
+
+void MainWindow::copySelection()
+{
+    if (!modelLoaded || model->selectedElements().isEmpty()) return;
+    model->copySelection();
+    pasteCount = 0;
+}
+
+void MainWindow::pasteSelection()
+{
+    // Each paste of the same copy is shifted further, so that the copies do not overlap
+    if (!modelLoaded || !model->canPaste()) return;
+    ++pasteCount;
+    model->paste(QPointF(pasteCount * pasteStep, -pasteCount * pasteStep));
+}
+
+void MainWindow::duplicateSelection()
+{
+    copySelection();
+    pasteSelection();
+}
+
+void MainWindow::transformSelection()
+{
+    if (!modelLoaded) return;
+
+    // Without a selection the whole network is transformed
+    TransformDialog dialog(model->elementsBounds().center(), this);
+    if (model->selectedElements().isEmpty())
+        dialog.setWindowTitle(tr("Transform Network"));
+    if (dialog.exec() != QDialog::Accepted) return;
+
+    QTime t;
+    t.start();
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    model->transformElements(dialog.transform());
+    QApplication::restoreOverrideCursor();
+    statusBar()->showMessage(tr("Ready. Elements transformed in %1ms.").arg(t.elapsed()));
+}
+
+void MainWindow::recomputeLengths()
+{
+    if (!modelLoaded) return;
+
+    bool ok;
+    double tolerance = QInputDialog::getDouble(this, tr("Recompute Lane Lengths"),
+                                               tr("Write the lengths that differ by more than (m):"), lengthTolerance, 0, 1000, 3, &ok);
+    if (!ok) return;
+    lengthTolerance = tolerance;
+
+    QTime t;
+    t.start();
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    int written = model->recomputeLengths(tolerance);
+    QApplication::restoreOverrideCursor();
+    statusBar()->showMessage(tr("Ready. %1 lane lengths updated in %2ms.").arg(written).arg(t.elapsed()));
+}
+
+void MainWindow::selectByQuery()
+{
+    if (!modelLoaded) return;
+
+    bool ok;
+    QString query = QInputDialog::getText(this, tr("Select by Query"),
+                                          tr("Query, e.g. lane.speed > 13.9 and lane.allow contains \"bus\":"),
+                                          QLineEdit::Normal, lastQuery, &ok).trimmed();
+    if (!ok || query.isEmpty()) return;
+    lastQuery = query;
+
+    QTime t;
+    t.start();
+    QString error;
+    if (!model->selectByQuery(query, error))
+    {
+        QMessageBox::warning(this, tr("Select by Query"), error);
+        return;
+    }
+    statusBar()->showMessage(tr("%1 elements selected in %2ms").arg(model->selectedElements().count()).arg(t.elapsed()));
+}
+
+void MainWindow::showSelectionCount(int count)
+{
+    statusBar()->showMessage(tr("%1 elements selected").arg(count));
+}
+
 void MainWindow::openJunctionEditor()
 {
     bool success = false;
@@ -383,6 +680,7 @@ void MainWindow::closeEvent(QCloseEvent *event)
     QSettings settings(QCoreApplication::applicationDirPath() + "/nefs.ini", QSettings::IniFormat);
     settings.setValue("paths/work", xmlPath.left(xmlPath.lastIndexOf('/')));
     settings.setValue("paths/sumo", sumoguiPath);
+    settings.setValue("export/width", exportWidth);
 }
 
 void MainWindow::openSUMO()
@@ -26,6 +26,8 @@
 #include "propsview.h"
 #include "editview.h"
 #include "controls.h"
+#include "minimap.h"
+#include "searchview.h"
 
 #include <QMainWindow>
 #include <QItemSelectionModel>
@@ -59,6 +61,12 @@ private slots:
     // Saves the model
     void saveAsFile();
 
+    // Exports the network to a PNG, SVG or PDF file
+    void exportImage();
+
+    // Starts or stops logging the rendering statistics into a CSV file
+    void logRenderStats(bool on);
+
     // Opens the last saved network in SUMO
     void openSUMO();
 
@@ -77,6 +85,36 @@ private slots:
     // Ensures the item is visible in the network view (when double clicked in the tree)
     void showItem(QModelIndex index);
 
+    // Shows the search dock and gives it the focus
+    void findElement();
+
+    // Selects an item picked in the search results and shows it in the network view
+    void showSearchResult(Item *item);
+
+    // Bulk operations on the elements selected in the network view
+    void deleteSelection();
+    void setSelectionAttribute();
+    void toggleSelectionVisibility();
+    void exportSelection();
+    void clearSelection();
+
+    // Copy the element selection, and paste it shifted from the original
+    void copySelection();
+    void pasteSelection();
+    void duplicateSelection();
+
+    // Translates, rotates and scales the element selection, or the whole network
+    void transformSelection();
+
+    // Writes the lengths of the lanes whose shapes no longer match their 'length' attribute
+    void recomputeLengths();
+
+    // Selects the elements matching an attribute query entered in a dialog
+    void selectByQuery();
+
+    // Shows the number of selected elements in the status bar
+    void showSelectionCount(int count);
+
 private:
     // Model instance
     Model *model;
@@ -86,8 +124,10 @@ private:
     QMenu *fileMenu;
     QMenu *viewMenu;
     QMenu *specialEditorsMenu;
+    QMenu *selectionMenu;
     QIcon nmlJuncIcon;
     QIcon tlLogicIcon;
+    QAction *logStatsAction;
 
     // Views and dock widgets
     QTreeView *tView;
@@ -98,12 +138,29 @@ private:
     QDockWidget *controlWidget;
     QDockWidget *propsWidget;
     QDockWidget *editWidget;
+    MiniMap *miniMap;
+    QDockWidget *miniMapWidget;
+    SearchView *searchView;
+    QDockWidget *searchWidget;
 
     // Last path from the File Dialog
     QString xmlPath;
 
     // Last path from the Locate SUMO Dialog
     QString sumoguiPath;
+
+    // Last image width used when exporting
+    int exportWidth;
+
+    // Last attribute query
+    QString lastQuery;
+
+    // Pastes of the last copy, and distance in metres between consecutive pastes
+    int pasteCount;
+    static const int pasteStep = 20;
+
+    // Last tolerance used when recomputing the lane lengths
+    double lengthTolerance;
 };
 
 #endif // MAINWINDOW_H
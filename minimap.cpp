@@ -0,0 +1,232 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#include "minimap.h"
+#include "model.h"
+#include "networkview.h"
+
+#include <QPainter>
+#include <QMouseEvent>
+#include <QtConcurrentRun>
+
+MiniMap::MiniMap(NetworkView *view, QWidget *parent) : QWidget(parent)
+{
+    // Initialise members
+    this->view = view;
+    model = 0;
+    fullRender = false;
+    generation = 0;
+
+    // Invalidations arriving within a short time are rendered together
+    renderTimer.setSingleShot(true);
+    renderTimer.setInterval(250);
+    connect(&renderTimer, SIGNAL(timeout()), this, SLOT(renderNext()));
+    connect(&watcher, SIGNAL(finished()), this, SLOT(regionRendered()));
+
+    setCursor(QCursor(Qt::CrossCursor));
+}
+
+QSize MiniMap::sizeHint() const
+{
+    return QSize(240, 180);
+}
+
+void MiniMap::setModel(Model *model)
+{
+    // Follow the geometry changes of the new model instead of the old one, if it still
+    // exists, and render all of it
+    if (this->model) disconnect(this->model, 0, this, 0);
+    this->model = model;
+    connect(model, SIGNAL(geometryChanged(QRectF)), this, SLOT(invalidate(QRectF)));
+    invalidate(QRectF());
+}
+
+void MiniMap::setVisibleArea(QRectF area)
+{
+    visibleArea = area;
+    update();
+}
+
+void MiniMap::invalidate(QRectF rect)
+{
+    if (rect.isNull())
+        fullRender = true;
+    else
+        dirty.append(rect);
+    renderTimer.start();
+}
+
+void MiniMap::renderNext()
+{
+    // Only one region is rendered at a time, and nothing while the dock is hidden
+    if (!model || watcher.isRunning() || !isVisible()) return;
+
+    Job job;
+    if (fullRender)
+    {
+        fullRender = false;
+        dirty.clear();
+        networkRect = model->netScene->itemsBoundingRect();
+        if (networkRect.isEmpty())
+        {
+            image = QImage();
+            update();
+            return;
+        }
+
+        // Fit the longest side of the network into the image; the y axis points downwards in the image
+        qreal scale = imageSize / qMax(networkRect.width(), networkRect.height());
+        sceneToImage.reset();
+        sceneToImage.scale(scale, -scale);
+        sceneToImage.translate(-networkRect.left(), -networkRect.bottom());
+        job.pixels = QRect(QPoint(0, 0), sceneToImage.mapRect(networkRect).toAlignedRect().size());
+        job.whole = true;
+        ++generation;
+    }
+    else if (!dirty.isEmpty())
+    {
+        // Take the first dirty region, merged with the rest if there are too many of them
+        QRectF region = dirty.takeFirst();
+        if (dirty.count() >= maxDirtyRegions)
+        {
+            while (!dirty.isEmpty())
+                region |= dirty.takeFirst();
+        }
+
+        // Edits outside the current image change its extent, so the whole network is rendered again
+        if (!networkRect.contains(region))
+        {
+            fullRender = true;
+            renderNext();
+            return;
+        }
+        job.pixels = sceneToImage.mapRect(region).toAlignedRect().adjusted(-1, -1, 1, 1) & image.rect();
+        if (job.pixels.isEmpty())
+        {
+            renderNext();
+            return;
+        }
+        job.whole = false;
+    }
+    else
+        return;
+
+    // Collect the elements in the scene thread and paint them in a worker thread
+    job.batch.addScene(model->netScene, sceneToImage.inverted().mapRect(QRectF(job.pixels)));
+    job.transform = sceneToImage;
+    job.background = model->netScene->backgroundBrush().color();
+    job.generation = generation;
+    watcher.setFuture(QtConcurrent::run(renderTile, job));
+}
+
+MiniMap::Tile MiniMap::renderTile(Job job)
+{
+    Tile tile;
+    tile.pixels = job.pixels;
+    tile.generation = job.generation;
+    tile.whole = job.whole;
+    tile.image = QImage(job.pixels.size(), QImage::Format_ARGB32_Premultiplied);
+    tile.image.fill(job.background);
+
+    // Paint the region, placing the top left pixel of the region at the origin of the tile
+    QPainter painter(&tile.image);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    painter.translate(-job.pixels.topLeft());
+    painter.setTransform(job.transform, true);
+    job.batch.paint(&painter, job.transform.inverted().mapRect(QRectF(job.pixels)));
+    painter.end();
+
+    return tile;
+}
+
+void MiniMap::regionRendered()
+{
+    Tile tile = watcher.result();
+    if (tile.whole)
+        image = tile.image;
+    else if (tile.generation == generation)
+    {
+        // Replace the pixels of the region in the cached image
+        QPainter painter(&image);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.drawImage(tile.pixels.topLeft(), tile.image);
+    }
+    update();
+
+    // Continue with the regions invalidated meanwhile
+    renderNext();
+}
+
+QTransform MiniMap::imageToWidget() const
+{
+    QTransform transform;
+    if (image.isNull()) return transform;
+
+    qreal scale = qMin(qreal(width()) / image.width(), qreal(height()) / image.height());
+    transform.translate((width() - scale * image.width()) / 2, (height() - scale * image.height()) / 2);
+    transform.scale(scale, scale);
+    return transform;
+}
+
+void MiniMap::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().dark());
+    if (image.isNull()) return;
+
+    // Draw the cached image scaled to fit
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+    painter.setTransform(imageToWidget());
+    painter.drawImage(0, 0, image);
+
+    // Draw the part of the network shown in the network view
+    painter.resetTransform();
+    QRectF area = (sceneToImage * imageToWidget()).mapRect(visibleArea);
+    painter.setPen(QPen(QColor(255, 0, 0), 1));
+    painter.setBrush(QColor(255, 0, 0, 40));
+    painter.drawRect(area);
+}
+
+void MiniMap::showEvent(QShowEvent *)
+{
+    renderNext();
+}
+
+void MiniMap::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton)
+        navigate(event->pos());
+}
+
+void MiniMap::mouseMoveEvent(QMouseEvent *event)
+{
+    if (event->buttons() & Qt::LeftButton)
+        navigate(event->pos());
+}
+
+void MiniMap::navigate(const QPoint &pos)
+{
+    if (image.isNull()) return;
+
+    // Map the widget position back into scene coordinates
+    QPointF scenePos = (sceneToImage * imageToWidget()).inverted().map(QPointF(pos));
+    view->centerOn(scenePos);
+}
@@ -0,0 +1,138 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#ifndef MINIMAP_H
+#define MINIMAP_H
+
+#include "renderbatch.h"
+
+#include <QWidget>
+#include <QImage>
+#include <QTransform>
+#include <QTimer>
+#include <QFutureWatcher>
+#include <QPointer>
+
+class Model;
+class NetworkView;
+
+class MiniMap : public QWidget
+{
+    Q_OBJECT
+public:
+    // Constructor; the minimap navigates the given network view
+    explicit MiniMap(NetworkView *view, QWidget *parent = 0);
+
+    // Shows the network of a new model, rendering it completely
+    void setModel(Model *model);
+
+    // Preferred size of the dock
+    QSize sizeHint() const;
+
+public slots:
+    // Updates the rectangle showing the part of the network visible in the network view
+    void setVisibleArea(QRectF area);
+
+    // Marks a region of the network (in scene coordinates) to be rendered again; a null rect marks everything
+    void invalidate(QRectF rect);
+
+protected:
+    // Draws the cached image scaled to the widget and the visible area of the network view
+    void paintEvent(QPaintEvent *);
+
+    // Renders the pending regions when the dock is shown again
+    void showEvent(QShowEvent *);
+
+    // Clicking or dragging centers the network view on the point under the mouse
+    void mousePressEvent(QMouseEvent *event);
+    void mouseMoveEvent(QMouseEvent *event);
+
+private slots:
+    // Starts rendering the next dirty region (or the whole network) in a worker thread
+    void renderNext();
+
+    // Copies the rendered region into the cached image
+    void regionRendered();
+
+private:
+    // Region of the network to be rendered in a worker thread; the batch is a copy of the
+    // scene elements, so the scene can keep changing while rendering
+    struct Job
+    {
+        RenderBatch batch;
+        QTransform transform;
+        QRect pixels;
+        QColor background;
+        int generation;
+        bool whole;
+    };
+
+    // Rendered region, placed at 'pixels' in the cached image
+    struct Tile
+    {
+        QImage image;
+        QRect pixels;
+        int generation;
+        bool whole;
+    };
+
+    // Renders a job into a tile; runs in a worker thread
+    static Tile renderTile(Job job);
+
+    // Network view navigated by the minimap and model shown in it
+    NetworkView *view;
+    QPointer<Model> model;
+
+    // Cached low resolution image of the network and transform from scene to image coordinates
+    QImage image;
+    QTransform sceneToImage;
+    QRectF networkRect;
+
+    // Size in pixels of the longest side of the cached image
+    static const int imageSize = 1024;
+
+    // Above this number of dirty regions they are rendered as a single one
+    static const int maxDirtyRegions = 32;
+
+    // Regions waiting to be rendered again, and whether the whole image has to be redone
+    QList<QRectF> dirty;
+    bool fullRender;
+
+    // Incremented on every full render, so that regions of a previous image are discarded
+    int generation;
+
+    // Groups the invalidations of an edit before rendering
+    QTimer renderTimer;
+
+    // Watches the rendering of the current region
+    QFutureWatcher<Tile> watcher;
+
+    // Visible area of the network view
+    QRectF visibleArea;
+
+    // Transform from image to widget coordinates (the image is scaled to fit, keeping its aspect ratio)
+    QTransform imageToWidget() const;
+
+    // Centers the network view on the network point under a widget position
+    void navigate(const QPoint &pos);
+};
+
+#endif // MINIMAP_H
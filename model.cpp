@@ -23,11 +23,40 @@
 #include "item.h"
 #include "pathelement.h"
 #include "pointelement.h"
+#include "animator.h"
+#include "attributetable.h"
+#include "labellayer.h"
+#include "snapindex.h"
+#include "turngenerator.h"
+#include "query.h"
+#include "netwriter.h"
+#include "netsource.h"
 
 #include <QtXml>
 #include <QDebug>
 #include <QDomNode>
 #include <QMessageBox>
+#include <qmath.h>
+#include <qnumeric.h>
+#include <QtConcurrentMap>
+#include <QSaveFile>
+
+// Id of the junction an internal element (":junction_index") belongs to: the leading ':' and then
+// the '_index' suffixes are stripped until 'junctions' contains the id, since junction ids may
+// contain underscores themselves. Empty if there is none
+template <typename Junctions>
+static QString ownerId(QString id, const Junctions &junctions)
+{
+    id.remove(0, 1);
+    while (!id.isEmpty())
+    {
+        if (junctions.contains(id)) return id;
+        int separator = id.lastIndexOf('_');
+        if (separator < 0) break;
+        id.truncate(separator);
+    }
+    return QString();
+}
 
 Model::Model(QFile *file, QObject *parent) : QAbstractItemModel(parent)
 {
@@ -36,6 +65,15 @@ Model::Model(QFile *file, QObject *parent) : QAbstractItemModel(parent)
 
     // Create a root item
     rootItem = new Item("Model", 0);
+    animator = 0;
+    attributes = new AttributeTable();
+    heatColumn = -1;
+    snap = new SnapIndex();
+    turns = new TurnGenerator(this);
+    source = new NetSource(file->fileName());
+    updateDepth = 0;
+    pendingAttr = false;
+    pendingGeometry = false;
 
     // Load icons
     nmlEdgeIcon = QPixmap(":/icons/edge1616.png");
@@ -62,7 +100,14 @@ Model::Model(QFile *file, QObject *parent) : QAbstractItemModel(parent)
 
 Model::~Model()
 {
+    // Stop highlighting elements that are about to be deleted
+    if (animator) animator->clear();
     delete rootItem;
+    delete attributes;
+    delete snap;
+    delete turns;
+    delete source;
+    clearQueryTables();
 }
 
 int Model::columnCount(const QModelIndex &/*parent*/) const
@@ -217,17 +262,36 @@ void Model::loadModel()
     loadConnections();
     emit statusUpdate(tr("Loading XML file: Traffic signals..."));
     loadSignals();
+
+    // Index the points the shape nodes can be snapped to
+    snap->clear();
+    snap->addScene(netScene);
+
+    // Link the junctions to the elements that move with them
+    buildTopology();
+
+    // Find the elements in the file, for the incremental saves
+    emit statusUpdate(tr("Loading XML file: Indexing file..."));
+    source->scan(domDocument.childNodes().at(netNodeIndex).toElement());
 }
 
-void Model::loadJunctions()
+void Model::loadJunctions(int first)
 {
-    // Add parent nodes for plain and internal junctions to the tree
-    Item *pjunc = new Item(tr("Plain Junctions"), 5, rootItem);
-    pJuncRow = rootItem->appendChild(pjunc);
+    // Add parent nodes for plain and internal junctions to the tree; pasted elements are appended to them
+    Item *pjunc, *ijunc;
+    if (first == 0)
+    {
+        pjunc = new Item(tr("Plain Junctions"), 5, rootItem);
+        pJuncRow = rootItem->appendChild(pjunc);
+        ijunc = new Item(tr("Internal Junctions"), 6, rootItem);
+        iJuncRow = rootItem->appendChild(ijunc);
+    }
+    else
+    {
+        pjunc = rootItem->child(pJuncRow);
+        ijunc = rootItem->child(iJuncRow);
+    }
     QModelIndex pIndex = index(pJuncRow, 0);
-
-    Item *ijunc = new Item(tr("Internal Junctions"), 6, rootItem);
-    iJuncRow = rootItem->appendChild(ijunc);
     QModelIndex iIndex = index(iJuncRow, 0);
 
     QDomElement element;
@@ -237,7 +301,7 @@ void Model::loadJunctions()
 
     // Scan all "junction" elements in <net>
     QDomNodeList netNode = domDocument.childNodes().at(netNodeIndex).childNodes();
-    for (unsigned int i = 0; i < netNode.length(); ++i)
+    for (unsigned int i = first; i < netNode.length(); ++i)
         if (netNode.at(i).nodeName() == "junction")
         {
             element = netNode.at(i).toElement();
@@ -302,29 +366,39 @@ void Model::loadJunctions()
         }
 }
 
-void Model::loadEdgesAndLanes()
+void Model::loadEdgesAndLanes(int first)
 {
-    // Add parent nodes for normal and internal edges to the tree
-    Item *nedges = new Item(tr("Normal Edges"), 1, rootItem);
-    nEdgeRow = rootItem->appendChild(nedges);
+    // Add parent nodes for normal and internal edges to the tree; pasted elements are appended to them
+    Item *nedges, *iedges;
+    if (first == 0)
+    {
+        nedges = new Item(tr("Normal Edges"), 1, rootItem);
+        nEdgeRow = rootItem->appendChild(nedges);
+        iedges = new Item(tr("Internal Edges"), 2, rootItem);
+        iEdgeRow = rootItem->appendChild(iedges);
+    }
+    else
+    {
+        nedges = rootItem->child(nEdgeRow);
+        iedges = rootItem->child(iEdgeRow);
+    }
     QModelIndex neIndex = index(nEdgeRow, 0);
-
-    Item *iedges = new Item(tr("Internal Edges"), 2, rootItem);
-    iEdgeRow = rootItem->appendChild(iedges);
     QModelIndex ieIndex = index(iEdgeRow, 0);
 
     QDomElement element;
     QString id, shape, from, to, a, b;
     PathElement *pathItem;
     QModelIndex edgeIndex;
-    int newRow;
+    int newRow, row, edgeRow;
+    QList<int> laneRows;
     bool internal;
 
     laneShapes.clear();
+    if (first == 0) attributes->clear();
 
     // Scan all "edge" elements in <net>
     QDomNodeList netNode = domDocument.childNodes().at(netNodeIndex).childNodes();
-    for (unsigned int i = 0; i < netNode.length(); ++i)
+    for (unsigned int i = first; i < netNode.length(); ++i)
         if (netNode.at(i).nodeName() == "edge")
         {
             element = netNode.at(i).toElement();
@@ -365,6 +439,10 @@ void Model::loadEdgesAndLanes()
             edgeIndex = index(newRow, 0, (internal ? ieIndex : neIndex));
             if (edgeItem->hasPath) pathItem->modelIndex = edgeIndex;
 
+            // Add the edge to the attribute table
+            edgeRow = (edgeItem->hasPath ? attributes->addRow(pathItem, i, -1) : -1);
+            laneRows.clear();
+
             // Scan lanes within edge
             for (unsigned int j = 0; j < netNode.at(i).childNodes().length(); ++j)
                 if (netNode.at(i).childNodes().at(j).nodeName() == "lane")
@@ -390,19 +468,35 @@ void Model::loadEdgesAndLanes()
 
                         // Add the id and shape of the lane into laneShape to use when loading connections
                         laneShapes.insert(id, shape);
+
+                        // Add the lane to the attribute table
+                        row = attributes->addRow(pathItem, i, j);
+                        attributes->setValue(row, AttributeTable::Speed, element.attribute("speed"));
+                        attributes->setValue(row, AttributeTable::Length, element.attribute("length"));
+                        attributes->setValue(row, AttributeTable::Width, element.attribute("width"));
+                        laneRows.append(row);
                     }
 
                     // Link the model item to the graphic element
                     if (laneItem->hasPath) pathItem->modelIndex = index(newRow, 0, edgeIndex);
                 }
+
+            // Share the values between the edge and its lanes
+            attributes->setEdge(edgeRow, laneRows, netNode.at(i).toElement().attribute("priority"));
         }
 }
 
-void Model::loadConnections()
+void Model::loadConnections(int first)
 {
     // Add parent node to the tree
-    Item *conn = new Item(tr("Connections"), 7, rootItem);
-    connRow = rootItem->appendChild(conn);
+    Item *conn;
+    if (first == 0)
+    {
+        conn = new Item(tr("Connections"), 7, rootItem);
+        connRow = rootItem->appendChild(conn);
+    }
+    else
+        conn = rootItem->child(connRow);
     QModelIndex cIndex = index(connRow, 0);
 
     QDomElement element;
@@ -414,7 +508,7 @@ void Model::loadConnections()
 
     // Scan all "connection" elements in <net>
     QDomNodeList netNode = domDocument.childNodes().at(netNodeIndex).childNodes();
-    for (unsigned int i = 0; i < netNode.length(); ++i)
+    for (unsigned int i = first; i < netNode.length(); ++i)
         if (netNode.at(i).nodeName() == "connection")
         {
             element = netNode.at(i).toElement();
@@ -485,18 +579,24 @@ void Model::loadConnections()
     laneShapes.clear();
 }
 
-void Model::loadSignals()
+void Model::loadSignals(int first)
 {
     // Add parent node to the tree
-    Item *tlLogics = new Item(tr("Traffic Lights"), 8, rootItem);
-    tllRow = rootItem->appendChild(tlLogics);
+    Item *tlLogics;
+    if (first == 0)
+    {
+        tlLogics = new Item(tr("Traffic Lights"), 8, rootItem);
+        tllRow = rootItem->appendChild(tlLogics);
+    }
+    else
+        tlLogics = rootItem->child(tllRow);
 
     QDomElement element;
     Item *junction;
 
     // Scan all "tlLogic" elements in <net>
     QDomNodeList netNode = domDocument.childNodes().at(netNodeIndex).childNodes();
-    for (unsigned int i = 0; i < netNode.length(); ++i)
+    for (unsigned int i = first; i < netNode.length(); ++i)
         if (netNode.at(i).nodeName() == "tlLogic")
         {
             element = netNode.at(i).toElement();
@@ -571,28 +671,1063 @@ void Model::selectionChanged(QItemSelection on, QItemSelection off)
 {
     Item *itemOn, *itemOff;
 
-    // Deselect item that was previously selected
-    if (off.indexes().count() > 0)
-        if (off.indexes()[0].isValid())
+    // A selection in the tree replaces the element selection
+    if (!on.isEmpty() && !elementSelection.isEmpty())
+        clearElementSelection();
+
+    // Deselect the items that were previously selected (one index per column)
+    QModelIndexList indexes = off.indexes();
+    for (int i = 0; i < indexes.count(); ++i)
+        if (indexes[i].isValid() && indexes[i].column() == 0)
+        {
+            itemOff = static_cast<Item*>(indexes[i].internalPointer());
+            if (itemOff->parent() != rootItem) selectGraphics(itemOff, false);
+        }
+
+    // Select the new items
+    indexes = on.indexes();
+    for (int i = 0; i < indexes.count(); ++i)
+        if (indexes[i].isValid() && indexes[i].column() == 0)
+        {
+            itemOn = static_cast<Item*>(indexes[i].internalPointer());
+            if (itemOn->parent() != rootItem) selectGraphics(itemOn, true);
+        }
+}
+
+void Model::selectGraphics(Item *item, bool on) const
+{
+    if (item->hasPath)
+    {
+        if (on) item->graphicItem1->select(); else item->graphicItem1->deselect();
+    }
+    if (item->hasPoint)
+    {
+        if (on) item->graphicItem2->select(); else item->graphicItem2->deselect();
+    }
+}
+
+void Model::selectElements(QList<Item*> items)
+{
+    // Clearing the tree selection also deselects its items
+    itemSelectionModel->clearSelection();
+
+    for (int i = 0; i < elementSelection.count(); ++i)
+        selectGraphics(elementSelection[i], false);
+    elementSelection = items;
+    for (int i = 0; i < elementSelection.count(); ++i)
+        selectGraphics(elementSelection[i], true);
+
+    emit elementSelectionChanged(elementSelection.count());
+}
+
+void Model::clearElementSelection()
+{
+    for (int i = 0; i < elementSelection.count(); ++i)
+        selectGraphics(elementSelection[i], false);
+    elementSelection.clear();
+
+    emit elementSelectionChanged(0);
+}
+
+const QList<Item*> &Model::selectedElements() const
+{
+    return elementSelection;
+}
+
+QDomElement Model::xmlElement(const QDomNodeList &netNode, const Item *item) const
+{
+    if (item->xmlSubNode > -1)
+        return netNode.at(item->xmlNode).childNodes().at(item->xmlSubNode).toElement();
+    return netNode.at(item->xmlNode).toElement();
+}
+
+void Model::deleteSelection()
+{
+    if (elementSelection.isEmpty()) return;
+
+    // Collect the items to remove; the lanes of a removed edge go with it
+    QSet<Item*> removed;
+    for (int i = 0; i < elementSelection.count(); ++i)
+    {
+        Item *item = elementSelection[i];
+        if (item->type == Item::Edge || item->type == Item::Lane || item->type == Item::Junction || item->type == Item::Connection)
+            removed.insert(item);
+    }
+
+    // A removed junction takes the normal edges starting or ending at it, and the internal edges
+    // and junctions lying within it
+    QDomNodeList netNode = domDocument.childNodes().at(netNodeIndex).childNodes();
+    Item *pjuncs = rootItem->child(pJuncRow), *ijuncs = rootItem->child(iJuncRow);
+    Item *nedges = rootItem->child(nEdgeRow), *iedges = rootItem->child(iEdgeRow);
+    QSet<QString> removedJunctions;
+    QSet<Item*>::const_iterator it;
+    for (it = removed.constBegin(); it != removed.constEnd(); ++it)
+        if ((*it)->parent() == pjuncs)
+            removedJunctions.insert((*it)->name);
+    if (!removedJunctions.isEmpty())
+    {
+        for (int i = 0; i < nedges->childCount(); ++i)
+        {
+            QDomElement element = xmlElement(netNode, nedges->child(i));
+            if (removedJunctions.contains(element.attribute("from")) || removedJunctions.contains(element.attribute("to")))
+                removed.insert(nedges->child(i));
+        }
+        Item *internals[] = { iedges, ijuncs };
+        for (int b = 0; b < 2; ++b)
+            for (int i = 0; i < internals[b]->childCount(); ++i)
+            {
+                Item *owner = junctionOwner(internals[b]->child(i)->name);
+                if (owner && removed.contains(owner))
+                    removed.insert(internals[b]->child(i));
+            }
+    }
+
+    // Connections from, to or through a removed lane would reference elements that no longer
+    // exist in the saved file, so they are removed as well
+    QSet<QString> removedEdges, removedLanes;
+    for (it = removed.constBegin(); it != removed.constEnd(); ++it)
+    {
+        if ((*it)->type == Item::Edge)
+        {
+            removedEdges.insert((*it)->name);
+            for (int j = 0; j < (*it)->childCount(); ++j)
+                removedLanes.insert((*it)->child(j)->name);
+        }
+        else if ((*it)->type == Item::Lane)
+            removedLanes.insert((*it)->name);
+    }
+    Item *conns = rootItem->child(connRow);
+    if (!removedEdges.isEmpty() || !removedLanes.isEmpty())
+    {
+        for (int i = 0; i < conns->childCount(); ++i)
+        {
+            QDomElement element = xmlElement(netNode, conns->child(i));
+            QString from = element.attribute("from"), to = element.attribute("to");
+            if (removedEdges.contains(from) || removedEdges.contains(to)
+                    || removedLanes.contains(from + "_" + element.attribute("fromLane"))
+                    || removedLanes.contains(to + "_" + element.attribute("toLane"))
+                    || removedLanes.contains(element.attribute("via")))
+                removed.insert(conns->child(i));
+        }
+
+        // The junctions left drop the removed lanes from their incoming and internal lane lists
+        const char *laneLists[] = { "incLanes", "intLanes" };
+        Item *junctionBranches[] = { pjuncs, ijuncs };
+        for (int b = 0; b < 2; ++b)
+            for (int i = 0; i < junctionBranches[b]->childCount(); ++i)
+            {
+                Item *junction = junctionBranches[b]->child(i);
+                if (removed.contains(junction)) continue;
+                QDomElement element = xmlElement(netNode, junction);
+                for (int l = 0; l < 2; ++l)
+                {
+                    QStringList lanes = element.attribute(laneLists[l]).split(' ', QString::SkipEmptyParts);
+                    int count = lanes.count();
+                    for (int j = count - 1; j >= 0; --j)
+                        if (removedLanes.contains(lanes[j])) lanes.removeAt(j);
+                    if (lanes.count() == count) continue;
+                    element.setAttribute(laneLists[l], lanes.join(" "));
+                    source->touch(element);
+                }
+            }
+    }
+
+    // Traffic lights lose the link indices only used by removed connections: the phase states
+    // drop their signal and the higher indices of the connections left move down
+    QHash<QString, QSet<int> > removedLinks, keptLinks;
+    QList<QDomElement> keptConnections;
+    for (int i = 0; i < conns->childCount(); ++i)
+    {
+        QDomElement element = xmlElement(netNode, conns->child(i));
+        QString tl = element.attribute("tl");
+        if (tl.isEmpty() || !element.hasAttribute("linkIndex")) continue;
+        int link = element.attribute("linkIndex").toInt();
+        if (removed.contains(conns->child(i)))
+            removedLinks[tl].insert(link);
+        else
+        {
+            keptLinks[tl].insert(link);
+            keptConnections.append(element);
+        }
+    }
+    QHash<QString, QVector<int> > droppedLinks;
+    QHash<QString, QSet<int> >::const_iterator tl;
+    for (tl = removedLinks.constBegin(); tl != removedLinks.constEnd(); ++tl)
+    {
+        QVector<int> dropped;
+        QSet<int>::const_iterator link;
+        for (link = tl->constBegin(); link != tl->constEnd(); ++link)
+            if (!keptLinks.value(tl.key()).contains(*link))
+                dropped.append(*link);
+        if (dropped.isEmpty()) continue;
+        qSort(dropped);
+        droppedLinks.insert(tl.key(), dropped);
+    }
+    for (int i = 0; i < keptConnections.count(); ++i)
+    {
+        QHash<QString, QVector<int> >::const_iterator links = droppedLinks.constFind(keptConnections[i].attribute("tl"));
+        if (links == droppedLinks.constEnd()) continue;
+        int link = keptConnections[i].attribute("linkIndex").toInt();
+        int shift = qLowerBound(links->begin(), links->end(), link) - links->begin();
+        if (shift == 0) continue;
+        keptConnections[i].setAttribute("linkIndex", link - shift);
+        source->touch(keptConnections[i]);
+    }
+    QHash<QString, QVector<int> >::const_iterator dropped;
+    for (dropped = droppedLinks.constBegin(); dropped != droppedLinks.constEnd(); ++dropped)
+    {
+        Item *logic = rootItem->child(tllRow)->child(dropped.key());
+        if (!logic) continue;
+        for (int j = 0; j < logic->childCount(); ++j)
+        {
+            QDomElement phase = xmlElement(netNode, logic->child(j));
+            QString state = phase.attribute("state");
+            for (int k = dropped->count() - 1; k >= 0; --k)
+                if (dropped->at(k) < state.length()) state.remove(dropped->at(k), 1);
+            phase.setAttribute("state", state);
+            source->touch(phase);
+        }
+    }
+
+    QList<Item*> items;
+    for (it = removed.constBegin(); it != removed.constEnd(); ++it)
+        if (!removed.contains((*it)->parent()))
+            items.append(*it);
+
+    // Find the XML nodes first, since removing nodes shifts the indices of the ones after them
+    QList<QDomNode> nodes;
+    QVector<int> removedNodes;
+    QHash<int, QVector<int> > removedSubNodes;
+    for (int i = 0; i < items.count(); ++i)
+    {
+        nodes.append(xmlElement(netNode, items[i]));
+        if (items[i]->xmlSubNode > -1)
+            removedSubNodes[items[i]->xmlNode].append(items[i]->xmlSubNode);
+        else
+            removedNodes.append(items[i]->xmlNode);
+    }
+
+    // Graphic elements of the items and the lanes of the removed edges
+    QSet<QGraphicsItem*> elements;
+    for (int i = 0; i < items.count(); ++i)
+        for (int j = -1; j < (items[i]->type == Item::Edge ? items[i]->childCount() : 0); ++j)
+        {
+            Item *item = (j < 0 ? items[i] : items[i]->child(j));
+            if (item->hasPath) elements.insert(item->graphicItem1);
+            if (item->hasPoint) elements.insert(item->graphicItem2);
+        }
+
+    // The traffic lights of removed junctions share their graphic elements; they stay in the
+    // network but are detached from the elements, which also drops their labels
+    Item *tlLogics = rootItem->child(tllRow);
+    for (int i = 0; i < tlLogics->childCount(); ++i)
+    {
+        Item *logic = tlLogics->child(i);
+        if (logic->hasPath && elements.contains(logic->graphicItem1))
+        {
+            logic->hasPath = false;
+            logic->graphicItem1 = 0;
+        }
+        if (logic->hasPoint && elements.contains(logic->graphicItem2))
+        {
+            logic->hasPoint = false;
+            logic->graphicItem2 = 0;
+        }
+    }
+
+    elementSelection.clear();
+    itemSelectionModel->clearSelection();
+    if (animator) animator->clear();
+
+    beginUpdate();
+    beginResetModel();
+
+    // Remove the graphic elements; as in the other delete functions they are not freed, since
+    // the view may still be processing an event of one of them
+    QSet<QGraphicsItem*>::const_iterator element;
+    for (element = elements.constBegin(); element != elements.constEnd(); ++element)
+    {
+        notifyGeometryChanged((*element)->sceneBoundingRect());
+        netScene->removeItem(*element);
+    }
+    forgetElements(elements);
+
+    // Remove the items from the tree, one pass per parent
+    QHash<Item*, QSet<Item*> > children;
+    for (int i = 0; i < items.count(); ++i)
+    {
+        children[items[i]->parent()].insert(items[i]);
+        links.remove(items[i]);
+        turns->removeJunction(items[i]);
+    }
+    QHash<Item*, QSet<Item*> >::const_iterator parent;
+    for (parent = children.constBegin(); parent != children.constEnd(); ++parent)
+        parent.key()->removeChildren(parent.value());
+
+    // Remove the XML elements and shift the indices of the items left
+    for (int i = 0; i < nodes.count(); ++i)
+    {
+        source->touch(nodes[i]);
+        nodes[i].parentNode().removeChild(nodes[i]);
+    }
+    qSort(removedNodes);
+    QHash<int, QVector<int> >::iterator sub;
+    for (sub = removedSubNodes.begin(); sub != removedSubNodes.end(); ++sub)
+        qSort(*sub);
+    renumberXML(rootItem, removedNodes, removedSubNodes);
+    attributes->reindex();
+
+    endResetModel();
+    refreshIndexes();
+    modified = true;
+    pendingAttr = true;
+    endUpdate();
+
+    emit elementSelectionChanged(0);
+}
+
+void Model::renumberXML(Item *item, const QVector<int> &removedNodes, const QHash<int, QVector<int> > &removedSubNodes)
+{
+    if (item->xmlNode > -1)
+    {
+        int node = item->xmlNode;
+        if (item->xmlSubNode > -1 && removedSubNodes.contains(node))
+        {
+            const QVector<int> &subNodes = removedSubNodes[node];
+            item->xmlSubNode -= qLowerBound(subNodes.begin(), subNodes.end(), item->xmlSubNode) - subNodes.begin();
+        }
+        item->xmlNode -= qLowerBound(removedNodes.begin(), removedNodes.end(), node) - removedNodes.begin();
+    }
+    for (int i = 0; i < item->childCount(); ++i)
+        renumberXML(item->child(i), removedNodes, removedSubNodes);
+}
+
+void Model::refreshIndexes()
+{
+    clearQueryTables();
+
+    // The traffic lights share the graphic elements of their junctions, so they are left out
+    for (int row = 0; row < rootItem->childCount(); ++row)
+    {
+        if (row == tllRow) continue;
+        QModelIndex branchIndex = index(row, 0);
+        Item *branch = rootItem->child(row);
+        for (int i = 0; i < branch->childCount(); ++i)
+        {
+            Item *item = branch->child(i);
+            QModelIndex itemIndex = index(i, 0, branchIndex);
+            if (item->hasPath) item->graphicItem1->modelIndex = itemIndex;
+            if (item->hasPoint) item->graphicItem2->modelIndex = itemIndex;
+
+            // Lanes of an edge
+            if (item->type != Item::Edge) continue;
+            for (int j = 0; j < item->childCount(); ++j)
+                if (item->child(j)->hasPath)
+                    item->child(j)->graphicItem1->modelIndex = index(j, 0, itemIndex);
+        }
+    }
+}
+
+void Model::setSelectionAttribute(const QString &attr, const QString &value)
+{
+    if (elementSelection.isEmpty()) return;
+
+    // Geometry is not written in bulk, since the graphic elements, the lengths and the turns would
+    // not follow it; the bulk editor shows these attributes read only
+    if (attr == "shape" || attr == "x" || attr == "y") return;
+
+    // The elements are found through one node list, and the views are updated once
+    QDomNodeList netNode = domDocument.childNodes().at(netNodeIndex).childNodes();
+    beginUpdate();
+    for (int i = 0; i < elementSelection.count(); ++i)
+    {
+        Item *item = elementSelection[i];
+        QDomElement element = xmlElement(netNode, item);
+        if (element.isNull()) continue;
+        element.setAttribute(attr, value);
+        source->touch(element);
+        updateAttributeTable(netNode, item->xmlNode, item->xmlSubNode, attr, value);
+    }
+    modified = true;
+    pendingAttr = true;
+    endUpdate();
+}
+
+void Model::selectionAttributes(const QStringList &attrs, QStringList &values, QList<bool> &mixed) const
+{
+    values.clear();
+    mixed.clear();
+    for (int a = 0; a < attrs.count(); ++a)
+    {
+        values.append(QString());
+        mixed.append(false);
+    }
+
+    QDomNodeList netNode = domDocument.childNodes().at(netNodeIndex).childNodes();
+    for (int i = 0; i < elementSelection.count(); ++i)
+    {
+        QDomElement element = xmlElement(netNode, elementSelection[i]);
+        for (int a = 0; a < attrs.count(); ++a)
+        {
+            if (mixed[a]) continue;
+            QString value = element.attribute(attrs[a]);
+            if (i == 0)
+                values[a] = value;
+            else if (value != values[a])
+            {
+                mixed[a] = true;
+                values[a].clear();
+            }
+        }
+    }
+}
+
+void Model::copySelection()
+{
+    clipboard.clear();
+    QDomNodeList netNode = domDocument.childNodes().at(netNodeIndex).childNodes();
+
+    // Lanes, requests and phases are copied with the element they belong to
+    QSet<int> nodes;
+    QHash<QString, Item*> junctions;
+    QSet<QString> edges;
+    for (int i = 0; i < elementSelection.count(); ++i)
+    {
+        Item *item = (elementSelection[i]->xmlSubNode > -1 ? elementSelection[i]->parent() : elementSelection[i]);
+        if (item->xmlNode < 0) continue;
+        nodes.insert(item->xmlNode);
+        if (item->type == Item::Junction) junctions.insert(item->name, item);
+        else if (item->type == Item::Edge) edges.insert(item->name);
+    }
+
+    // Internal edges and junctions of the copied junctions
+    Item *branch = rootItem->child(iEdgeRow);
+    for (int i = 0; i < branch->childCount(); ++i)
+        if (junctionOwner(branch->child(i)->name, junctions))
+        {
+            nodes.insert(branch->child(i)->xmlNode);
+            edges.insert(branch->child(i)->name);
+        }
+    branch = rootItem->child(iJuncRow);
+    for (int i = 0; i < branch->childCount(); ++i)
+        if (junctionOwner(branch->child(i)->name, junctions))
+            nodes.insert(branch->child(i)->xmlNode);
+
+    // Connections whose edges, and internal lane if any, are all copied; the traffic lights
+    // controlling them are copied too, since joined traffic lights have an id of their own
+    QSet<QString> logics;
+    branch = rootItem->child(connRow);
+    for (int i = 0; i < branch->childCount(); ++i)
+    {
+        QDomElement element = netNode.at(branch->child(i)->xmlNode).toElement();
+        QString via = element.attribute("via");
+        if (edges.contains(element.attribute("from")) && edges.contains(element.attribute("to")) &&
+            (via.isEmpty() || edges.contains(via.left(via.lastIndexOf('_')))))
+        {
+            nodes.insert(branch->child(i)->xmlNode);
+            if (element.hasAttribute("tl")) logics.insert(element.attribute("tl"));
+        }
+    }
+
+    // Traffic lights of the copied junctions, with the id of the junction, and of the copied connections
+    QHash<QString, Item*>::const_iterator junction;
+    for (junction = junctions.constBegin(); junction != junctions.constEnd(); ++junction)
+        logics.insert(junction.key());
+    QSet<QString>::const_iterator id;
+    for (id = logics.constBegin(); id != logics.constEnd(); ++id)
+    {
+        Item *logic = rootItem->child(tllRow)->child(*id);
+        if (logic) nodes.insert(logic->xmlNode);
+    }
+
+    QList<int> sorted = nodes.toList();
+    qSort(sorted);
+    for (int i = 0; i < sorted.count(); ++i)
+        clipboard.append(netNode.at(sorted[i]).cloneNode(true).toElement());
+    emit statusUpdate(tr("%1 elements copied").arg(clipboard.count()));
+}
+
+bool Model::canPaste() const
+{
+    return !clipboard.isEmpty();
+}
+
+// New id of an internal element (":junction_index"), from the new id of its junction; empty if
+// the junction was not copied
+static QString internalId(const QString &id, const QHash<QString, QString> &junctionIds)
+{
+    QString junction = ownerId(id, junctionIds);
+    if (junction.isEmpty()) return QString();
+    return ":" + junctionIds.value(junction) + id.mid(1 + junction.length());
+}
+
+// Replaces an attribute holding an id, or a space separated list of ids, with the new ids
+static void remapAttribute(QDomElement &element, const QString &attr, const QHash<QString, QString> &ids)
+{
+    if (!element.hasAttribute(attr)) return;
+    QStringList list = element.attribute(attr).split(' ', QString::SkipEmptyParts);
+    for (int i = 0; i < list.count(); ++i)
+        list[i] = ids.value(list[i], list[i]);
+    element.setAttribute(attr, list.join(" "));
+}
+
+void Model::paste(const QPointF &offset)
+{
+    if (clipboard.isEmpty()) return;
+
+    // Find a suffix that gives new ids to all the copied junctions, edges and traffic lights
+    QString suffix;
+    for (int serial = 1; suffix.isEmpty(); ++serial)
+    {
+        suffix = QString("_copy%1").arg(serial);
+        for (int i = 0; i < clipboard.count(); ++i)
+        {
+            QString tag = clipboard[i].tagName(), id = clipboard[i].attribute("id");
+            int row = (tag == "junction" ? pJuncRow : tag == "edge" ? nEdgeRow : tag == "tlLogic" ? tllRow : -1);
+            if (row >= 0 && !id.isEmpty() && rootItem->child(row)->child(id + suffix))
+            {
+                suffix.clear();
+                break;
+            }
+        }
+    }
+
+    // New ids; internal elements take theirs from their junction, and lanes from their edge
+    QHash<QString, QString> junctionIds, edgeIds, laneIds, tlIds;
+    for (int pass = 0; pass < 2; ++pass)
+        for (int i = 0; i < clipboard.count(); ++i)
+        {
+            QString tag = clipboard[i].tagName(), id = clipboard[i].attribute("id");
+            if (id.isEmpty() || id.startsWith(':') != (pass == 1)) continue;
+            QString newId = (pass == 0 ? id + suffix : internalId(id, junctionIds));
+            if (newId.isEmpty()) newId = id + suffix;
+            if (tag == "junction") junctionIds.insert(id, newId);
+            else if (tag == "tlLogic") tlIds.insert(id, newId);
+            else if (tag == "edge")
+            {
+                edgeIds.insert(id, newId);
+                for (QDomElement lane = clipboard[i].firstChildElement("lane"); !lane.isNull(); lane = lane.nextSiblingElement("lane"))
+                {
+                    QString laneId = lane.attribute("id");
+                    laneIds.insert(laneId, laneId.startsWith(id) ? newId + laneId.mid(id.length()) : laneId + suffix);
+                }
+            }
+        }
+
+    // Append the remapped and shifted copies to <net>, after all the other elements
+    QDomNode net = domDocument.childNodes().at(netNodeIndex);
+    int first = net.childNodes().count();
+    for (int i = 0; i < clipboard.count(); ++i)
+    {
+        QDomElement element = clipboard[i].cloneNode(true).toElement();
+        QString tag = element.tagName();
+        if (tag == "junction")
+        {
+            remapAttribute(element, "id", junctionIds);
+            remapAttribute(element, "incLanes", laneIds);
+            remapAttribute(element, "intLanes", laneIds);
+            if (element.hasAttribute("x")) element.setAttribute("x", QString::number(element.attribute("x").toDouble() + offset.x(), 'f', 2));
+            if (element.hasAttribute("y")) element.setAttribute("y", QString::number(element.attribute("y").toDouble() + offset.y(), 'f', 2));
+        }
+        else if (tag == "edge")
+        {
+            remapAttribute(element, "id", edgeIds);
+            remapAttribute(element, "from", junctionIds);
+            remapAttribute(element, "to", junctionIds);
+            for (QDomElement lane = element.firstChildElement("lane"); !lane.isNull(); lane = lane.nextSiblingElement("lane"))
+            {
+                remapAttribute(lane, "id", laneIds);
+                if (lane.hasAttribute("shape")) lane.setAttribute("shape", shiftShape(lane.attribute("shape"), offset));
+            }
+        }
+        else if (tag == "connection")
         {
-            itemOff = static_cast<Item*>(off.indexes()[0].internalPointer());
-            if (itemOff->parent() != rootItem && itemOff->hasPath)
-                itemOff->graphicItem1->deselect();
-            if (itemOff->parent() != rootItem && itemOff->hasPoint)
-                itemOff->graphicItem2->deselect();
+            remapAttribute(element, "from", edgeIds);
+            remapAttribute(element, "to", edgeIds);
+            remapAttribute(element, "via", laneIds);
+            remapAttribute(element, "tl", tlIds);
         }
+        else if (tag == "tlLogic")
+            remapAttribute(element, "id", tlIds);
+        if (element.hasAttribute("shape")) element.setAttribute("shape", shiftShape(element.attribute("shape"), offset));
+        net.appendChild(element);
+    }
 
-    // Select the new item
-    if (on.indexes().count() > 0)
-        if (on.indexes()[0].isValid())
+    // Load the new elements into the tree and the scene in one batch
+    beginUpdate();
+    beginResetModel();
+    loadJunctions(first);
+    loadEdgesAndLanes(first);
+    loadConnections(first);
+    loadSignals(first);
+    endResetModel();
+
+    // Index the new elements and select them
+    QList<Item*> pasted;
+    QRectF bounds;
+    for (int row = 0; row < rootItem->childCount(); ++row)
+    {
+        Item *branch = rootItem->child(row);
+        for (int i = branch->childCount() - 1; i >= 0 && branch->child(i)->xmlNode >= first; --i)
         {
-            itemOn = static_cast<Item*>(on.indexes()[0].internalPointer());
-            qDebug() << "Model::selectionChanged on signal for item name: " << itemOn->name;
-            if (itemOn->parent() != rootItem && itemOn->hasPath)
-                itemOn->graphicItem1->select();
-            if (itemOn->parent() != rootItem && itemOn->hasPoint)
-                itemOn->graphicItem2->select();
+            Item *item = branch->child(i);
+            pasted.prepend(item);
+            if (row == tllRow) continue;
+            for (int j = -1; j < item->childCount(); ++j)
+            {
+                Item *element = (j < 0 ? item : item->child(j));
+                if (element->hasPath)
+                {
+                    snap->setPoints(element->graphicItem1, element->graphicItem1->snapPoints());
+                    bounds |= element->graphicItem1->sceneBoundingRect();
+                }
+                if (element->hasPoint)
+                {
+                    snap->setPoints(element->graphicItem2, element->graphicItem2->snapPoints());
+                    bounds |= element->graphicItem2->sceneBoundingRect();
+                }
+            }
         }
+    }
+    linkTopology(pasted);
+    clearQueryTables();
+    modified = true;
+    notifyGeometryChanged(bounds);
+    selectElements(pasted);
+    endUpdate();
+
+    emit statusUpdate(tr("%1 elements pasted").arg(clipboard.count()));
+}
+
+void Model::transformElements(const QTransform &transform)
+{
+    // Graphic elements of the items and of the lanes of their edges; traffic lights share the
+    // elements of their junction, so each element is taken once
+    QList<Item*> items = transformedItems();
+    QList<PathElement*> paths;
+    QList<PointElement*> points;
+    QSet<QGraphicsItem*> seen;
+    for (int i = 0; i < items.count(); ++i)
+        for (int j = -1; j < (items[i]->type == Item::Edge ? items[i]->childCount() : 0); ++j)
+        {
+            Item *item = (j < 0 ? items[i] : items[i]->child(j));
+            if (item->hasPath && !seen.contains(item->graphicItem1))
+            {
+                seen.insert(item->graphicItem1);
+                paths.append(item->graphicItem1);
+            }
+            if (item->hasPoint && !seen.contains(item->graphicItem2))
+            {
+                seen.insert(item->graphicItem2);
+                points.append(item->graphicItem2);
+            }
+        }
+
+    // Gather all the coordinates into two arrays; the nodes of path i start at starts[i], and the
+    // points follow the paths
+    QVector<int> starts(paths.count() + 1);
+    int count = 0;
+    for (int i = 0; i < paths.count(); ++i)
+    {
+        starts[i] = count;
+        count += paths[i]->pathNodes().count();
+    }
+    starts[paths.count()] = count;
+    QVector<double> xs(count + points.count()), ys(count + points.count());
+    for (int i = 0; i < paths.count(); ++i)
+    {
+        const QList<QPointF> &nodes = paths[i]->pathNodes();
+        for (int k = 0; k < nodes.count(); ++k)
+        {
+            xs[starts[i] + k] = nodes[k].x();
+            ys[starts[i] + k] = nodes[k].y();
+        }
+    }
+    for (int i = 0; i < points.count(); ++i)
+    {
+        xs[count + i] = points[i]->position().x();
+        ys[count + i] = points[i]->position().y();
+    }
+
+    // One branch free pass over the arrays, which the compiler can vectorise
+    const double m11 = transform.m11(), m12 = transform.m12(), m21 = transform.m21(), m22 = transform.m22();
+    const double dx = transform.dx(), dy = transform.dy();
+    double *px = xs.data(), *py = ys.data();
+    for (int i = 0; i < xs.count(); ++i)
+    {
+        double x = px[i], y = py[i];
+        px[i] = m11 * x + m21 * y + dx;
+        py[i] = m12 * x + m22 * y + dy;
+    }
+
+    // Write the coordinates back into the elements and the XML domDocument, through one node list.
+    // The elements are not invalidated one by one: the area before and after is reported once,
+    // and when most of the network moves the scene index is rebuilt once instead of updated per item
+    QDomNodeList netNode = domDocument.childNodes().at(netNodeIndex).childNodes();
+    QGraphicsScene::ItemIndexMethod indexMethod = netScene->itemIndexMethod();
+    int elementCount = 0;
+    int rows[] = { pJuncRow, iJuncRow, nEdgeRow, iEdgeRow, connRow };
+    for (int r = 0; r < 5; ++r)
+    {
+        Item *branch = rootItem->child(rows[r]);
+        elementCount += branch->childCount();
+        if (rows[r] == nEdgeRow || rows[r] == iEdgeRow)
+            for (int i = 0; i < branch->childCount(); ++i)
+                elementCount += branch->child(i)->childCount();
+    }
+    bool rebuildIndex = (paths.count() + points.count() > elementCount / 2);
+    if (rebuildIndex) netScene->setItemIndexMethod(QGraphicsScene::NoIndex);
+    QRectF bounds;
+    beginUpdate();
+    for (int i = 0; i < paths.count(); ++i)
+    {
+        QList<QPointF> nodes;
+        for (int k = starts[i]; k < starts[i + 1]; ++k)
+            nodes.append(QPointF(xs[k], ys[k]));
+        bounds |= paths[i]->sceneBoundingRect();
+        paths[i]->setNodes(nodes);
+        bounds |= paths[i]->sceneBoundingRect();
+
+        // Connections and edges without a shape are drawn from other elements
+        PathElement::ElementType type = paths[i]->type;
+        if (type == PathElement::Connection || type == PathElement::EdgeNoShape) continue;
+        Item *item = paths[i]->getItem();
+        QDomElement element = xmlElement(netNode, item);
+
+        // Points are "x,y" or "x,y,z"; the z coordinates of the old shape are kept, matched by node
+        // index, which holds only when the element has one node per shape point
+        QStringList oldPoints = element.attribute("shape").split(' ', QString::SkipEmptyParts);
+        if (oldPoints.count() != starts[i + 1] - starts[i]) oldPoints.clear();
+        QString shape;
+        double length = 0;
+        for (int k = starts[i]; k < starts[i + 1]; ++k)
+        {
+            int n = k - starts[i];
+            if (n > 0)
+            {
+                shape += " ";
+                length += qSqrt((xs[k] - xs[k - 1]) * (xs[k] - xs[k - 1]) + (ys[k] - ys[k - 1]) * (ys[k] - ys[k - 1]));
+            }
+            shape += QString::number(xs[k], 'f', 2) + "," + QString::number(ys[k], 'f', 2);
+            if (n < oldPoints.count())
+            {
+                QStringList coords = oldPoints[n].split(',');
+                if (coords.count() > 2) shape += "," + coords[2];
+            }
+        }
+        element.setAttribute("shape", shape);
+        source->touch(element);
+        if (type == PathElement::NormalLane || type == PathElement::IntLane)
+        {
+            QString value = QString::number(length, 'f', 2);
+            element.setAttribute("length", value);
+            updateAttributeTable(netNode, item->xmlNode, item->xmlSubNode, "length", value);
+        }
+    }
+    for (int i = 0; i < points.count(); ++i)
+    {
+        bounds |= points[i]->sceneBoundingRect();
+        points[i]->setPosition(QPointF(xs[count + i], ys[count + i]));
+        bounds |= points[i]->sceneBoundingRect();
+        if (points[i]->type == PointElement::Connection) continue;
+        QDomElement element = xmlElement(netNode, points[i]->getItem());
+        element.setAttribute("x", QString::number(xs[count + i], 'f', 2));
+        element.setAttribute("y", QString::number(ys[count + i], 'f', 2));
+        source->touch(element);
+    }
+    if (rebuildIndex) netScene->setItemIndexMethod(indexMethod);
+
+    // A whole network transform moves the network boundary, and a translation its offset too; the
+    // offset maps the projected coordinates by a translation only, so other transforms leave it
+    QDomElement location = domDocument.childNodes().at(netNodeIndex).firstChildElement("location");
+    if (elementSelection.isEmpty() && !location.isNull() && !xs.isEmpty())
+    {
+        double minX = xs[0], maxX = xs[0], minY = ys[0], maxY = ys[0];
+        for (int i = 1; i < xs.count(); ++i)
+        {
+            minX = qMin(minX, xs[i]);
+            maxX = qMax(maxX, xs[i]);
+            minY = qMin(minY, ys[i]);
+            maxY = qMax(maxY, ys[i]);
+        }
+        location.setAttribute("convBoundary", QString::number(minX, 'f', 2) + "," + QString::number(minY, 'f', 2) + "," +
+                              QString::number(maxX, 'f', 2) + "," + QString::number(maxY, 'f', 2));
+        QStringList offset = location.attribute("netOffset").split(',');
+        if (transform.type() <= QTransform::TxTranslate && offset.count() == 2)
+            location.setAttribute("netOffset", QString::number(offset[0].toDouble() + dx, 'f', 2) + "," +
+                                  QString::number(offset[1].toDouble() + dy, 'f', 2));
+        source->touch(location);
+    }
+
+    notifyGeometryChanged(bounds);
+    clearQueryTables();
+    modified = true;
+    pendingAttr = true;
+    endUpdate();
+}
+
+// Lane measured by Model::recomputeLengths()
+struct LaneLength
+{
+    PathElement *lane;
+    int row;
+    qreal length;
+};
+
+// Measures a lane; runs in a worker thread, reading the nodes only
+static void measureLane(LaneLength &lane)
+{
+    lane.length = PathElement::polylineLength(lane.lane->pathNodes());
+}
+
+int Model::recomputeLengths(qreal tolerance)
+{
+    // The lanes with a shape are the lane rows of the attribute table
+    QVector<LaneLength> lanes;
+    for (int row = 0; row < attributes->rowCount(); ++row)
+    {
+        PathElement *element = attributes->element(row);
+        if (!element || !element->scene() || (element->type != PathElement::NormalLane && element->type != PathElement::IntLane)) continue;
+        LaneLength lane;
+        lane.lane = element;
+        lane.row = row;
+        lanes.append(lane);
+    }
+    QtConcurrent::blockingMap(lanes, measureLane);
+
+    // Write the stale lengths through one node list; the stored lengths are compared in the
+    // attribute table, so that the XML is only read for the lanes written
+    QDomNodeList netNode = domDocument.childNodes().at(netNodeIndex).childNodes();
+    int written = 0;
+    beginUpdate();
+    for (int i = 0; i < lanes.count(); ++i)
+    {
+        float stored = attributes->value(lanes[i].row, AttributeTable::Length);
+        if (!qIsNaN(stored) && qAbs(lanes[i].length - stored) <= tolerance) continue;
+
+        Item *item = lanes[i].lane->getItem();
+        QString value = QString::number(lanes[i].length, 'f', 2);
+        QDomElement element = xmlElement(netNode, item);
+        element.setAttribute("length", value);
+        source->touch(element);
+
+        // Edges have no length attribute, but updateAttributeTable() gives them the mean length of their lanes
+        updateAttributeTable(netNode, item->xmlNode, item->xmlSubNode, "length", value);
+        ++written;
+    }
+
+    if (written > 0)
+    {
+        modified = true;
+        pendingAttr = true;
+    }
+    endUpdate();
+    return written;
+}
+
+QRectF Model::elementsBounds() const
+{
+    if (elementSelection.isEmpty()) return netScene->itemsBoundingRect();
+
+    QRectF bounds;
+    for (int i = 0; i < elementSelection.count(); ++i)
+    {
+        Item *item = elementSelection[i];
+        if (item->hasPath) bounds |= item->graphicItem1->sceneBoundingRect();
+        if (item->hasPoint) bounds |= item->graphicItem2->sceneBoundingRect();
+    }
+    return bounds;
+}
+
+QList<Item*> Model::transformedItems() const
+{
+    if (!elementSelection.isEmpty()) return elementSelection;
+
+    // Everything but the traffic lights, which share the elements of their junctions
+    QList<Item*> items;
+    for (int row = 0; row < rootItem->childCount(); ++row)
+    {
+        if (row == tllRow) continue;
+        Item *branch = rootItem->child(row);
+        for (int i = 0; i < branch->childCount(); ++i)
+            items.append(branch->child(i));
+    }
+    return items;
+}
+
+QString Model::shiftShape(const QString &shape, const QPointF &offset)
+{
+    // Points are "x,y" or "x,y,z"; only x and y are shifted
+    QStringList points = shape.split(' ', QString::SkipEmptyParts);
+    for (int i = 0; i < points.count(); ++i)
+    {
+        QStringList coords = points[i].split(',');
+        if (coords.count() < 2) continue;
+        coords[0] = QString::number(coords[0].toDouble() + offset.x(), 'f', 2);
+        coords[1] = QString::number(coords[1].toDouble() + offset.y(), 'f', 2);
+        points[i] = coords.join(",");
+    }
+    return points.join(" ");
+}
+
+bool Model::selectByQuery(const QString &text, QString &error)
+{
+    Query query;
+    if (!query.compile(text, error)) return false;
+
+    QString kind = query.kind();
+    Item::XMLElement type = (kind == "edge" ? Item::Edge : kind == "lane" ? Item::Lane :
+                             kind == "junction" ? Item::Junction : kind == "connection" ? Item::Connection : Item::tlLogic);
+    QueryTable *table = queryTable(type);
+    if (!query.bind(table, error)) return false;
+
+    QVector<int> rows = query.evaluate();
+    QList<Item*> items;
+    items.reserve(rows.count());
+    for (int i = 0; i < rows.count(); ++i)
+        items.append(table->item(rows[i]));
+    selectElements(items);
+    return true;
+}
+
+QueryTable *Model::queryTable(int type)
+{
+    QueryTable *table = queryTables.value(type);
+    if (table) return table;
+
+    // Items of the type, anywhere below the captions
+    QVector<Item*> items;
+    QVector<QDomElement> elements;
+    QDomNodeList netNode = domDocument.childNodes().at(netNodeIndex).childNodes();
+    QList<Item*> pending;
+    for (int i = 0; i < rootItem->childCount(); ++i)
+        pending.append(rootItem->child(i));
+    while (!pending.isEmpty())
+    {
+        Item *parent = pending.takeLast();
+        for (int i = 0; i < parent->childCount(); ++i)
+        {
+            Item *item = parent->child(i);
+            if (item->type == type)
+            {
+                items.append(item);
+                elements.append(xmlElement(netNode, item));
+            }
+            if (item->type == Item::Edge && type == Item::Lane) pending.append(item);
+        }
+    }
+    table = new QueryTable(items, elements);
+
+    // Computed columns: the number of lanes of the edges, and the number of normal edges
+    // entering or leaving the junctions
+    if (type == Item::Edge)
+    {
+        QVector<float> lanes(items.count());
+        for (int i = 0; i < items.count(); ++i)
+            lanes[i] = items[i]->childCount();
+        table->addColumn("numLanes", lanes);
+    }
+    else if (type == Item::Junction)
+    {
+        QHash<QString, int> degrees;
+        Item *edges = rootItem->child(nEdgeRow);
+        for (int i = 0; i < edges->childCount(); ++i)
+        {
+            QDomElement edge = xmlElement(netNode, edges->child(i));
+            ++degrees[edge.attribute("from")];
+            ++degrees[edge.attribute("to")];
+        }
+        QVector<float> degree(items.count());
+        for (int i = 0; i < items.count(); ++i)
+            degree[i] = degrees.value(items[i]->name);
+        table->addColumn("degree", degree);
+    }
+
+    queryTables.insert(type, table);
+    return table;
+}
+
+void Model::clearQueryTables()
+{
+    qDeleteAll(queryTables);
+    queryTables.clear();
+}
+
+void Model::updateQueryTables(int node, int subNode, const QString &attr, const QString &value)
+{
+    // The tables holding the element are updated in place; a table is dropped, to be built again by
+    // the next query, when the value does not fit its column. The degree of the junctions is
+    // computed from the ends of the edges
+    QHash<int, QueryTable*>::iterator table = queryTables.begin();
+    while (table != queryTables.end())
+    {
+        int row = (*table)->findRow(node, subNode);
+        bool stale = (row >= 0 && !(*table)->setValue(row, attr, value)) ||
+                     (table.key() == Item::Junction && (attr == "from" || attr == "to"));
+        if (stale)
+        {
+            delete *table;
+            table = queryTables.erase(table);
+        }
+        else
+            ++table;
+    }
+}
+
+void Model::setSelectionVisible(bool visible)
+{
+    beginUpdate();
+    for (int i = 0; i < elementSelection.count(); ++i)
+    {
+        Item *item = elementSelection[i];
+        if (item->hasPath)
+        {
+            item->graphicItem1->switchState(ViewElement, visible);
+            notifyGeometryChanged(item->graphicItem1->sceneBoundingRect());
+        }
+        if (item->hasPoint)
+        {
+            item->graphicItem2->switchState(ViewElement, visible);
+            notifyGeometryChanged(item->graphicItem2->sceneBoundingRect());
+        }
+    }
+    endUpdate();
+}
+
+bool Model::selectionVisible() const
+{
+    for (int i = 0; i < elementSelection.count(); ++i)
+    {
+        Item *item = elementSelection[i];
+        if ((item->hasPath && item->graphicItem1->isVisible()) || (item->hasPoint && item->graphicItem2->isVisible()))
+            return true;
+    }
+    return false;
+}
+
+bool Model::exportSelection(QIODevice *device, QString *errorMessage) const
+{
+    // Lanes are written with their edge, since the edge is the unit of a network file
+    QSet<int> nodeSet;
+    for (int i = 0; i < elementSelection.count(); ++i)
+        if (elementSelection[i]->xmlNode > -1)
+            nodeSet.insert(elementSelection[i]->xmlNode);
+    QList<int> nodes = nodeSet.toList();
+    qSort(nodes);
+
+    // The subset keeps the <net> attributes and the <location> element, and the order of the elements
+    QDomNode net = domDocument.childNodes().at(netNodeIndex);
+    QDomDocument subset;
+    QDomNode subsetNet = subset.appendChild(subset.importNode(net, false));
+    QDomElement location = net.firstChildElement("location");
+    if (!location.isNull()) subsetNet.appendChild(subset.importNode(location, true));
+    QDomNodeList netNode = net.childNodes();
+    for (int i = 0; i < nodes.count(); ++i)
+        subsetNet.appendChild(subset.importNode(netNode.at(nodes[i]), true));
+
+    // Written as a saved network is, with the same attribute order and indentation
+    NetWriter writer;
+    return writer.write(subset, device, errorMessage);
 }
 
 void Model::setSelectionModel(QItemSelectionModel *selectionModel)
@@ -604,26 +1739,78 @@ void Model::setSelectionModel(QItemSelectionModel *selectionModel)
 void Model::editAttribute(int node, int subNode, QString attr, QString value)
 {
     // Update the XML domDocument attribute
+    QDomNodeList netNode = domDocument.childNodes().at(netNodeIndex).childNodes();
+    QDomElement element;
     if (subNode > -1)
-        domDocument.childNodes().at(netNodeIndex).childNodes().at(node).childNodes().at(subNode)
-                .toElement().setAttribute(attr, value);
+        element = netNode.at(node).childNodes().at(subNode).toElement();
     else
-        domDocument.childNodes().at(netNodeIndex).childNodes().at(node)
-                .toElement().setAttribute(attr, value);
+        element = netNode.at(node).toElement();
+    element.setAttribute(attr, value);
+    source->touch(element);
 
     modified = true;
+    updateAttributeTable(netNode, node, subNode, attr, value);
 
     // Emit a signal so that the properties view is updated
-    emit attrUpdate(itemSelectionModel->selection(), itemSelectionModel->selection());
+    if (updateDepth > 0)
+        pendingAttr = true;
+    else
+        emit attrUpdate(itemSelectionModel->selection(), itemSelectionModel->selection());
+}
+
+void Model::updateAttributeTable(const QDomNodeList &netNode, int node, int subNode, const QString &attr, const QString &value)
+{
+    updateQueryTables(node, subNode, attr, value);
+
+    // Keep the attribute table up to date
+    int column = AttributeTable::columnOf(attr);
+    if (column < 0) return;
+    int row = attributes->findRow(node, subNode);
+    if (row >= 0) attributes->setValue(row, column, value);
+
+    // The edge takes the means of its lanes and the lanes take the priority of their edge, so the
+    // rows of the whole edge are filled in again; edges without a shape have no row of their own
+    // and are found through their first lane
+    int found = (row >= 0 ? row : attributes->findRow(node, 0));
+    if (found < 0) return;
+    Item *edge = attributes->element(found)->getItem();
+    if (edge->type == Item::Lane) edge = edge->parent();
+    QList<int> rows = updateEdgeRows(netNode, edge);
+
+    // Recolour the rows if the heatmap shows the column
+    if (column != heatColumn) return;
+    for (int i = 0; i < rows.count(); ++i)
+    {
+        float v = attributes->value(rows[i], column);
+        float t = (heatMax > heatMin ? (v - heatMin) / (heatMax - heatMin) : 0);
+        attributes->element(rows[i])->setColourOverride(v == v ? heatRamp.colourAt(t) : QRgb(0));
+        notifyGeometryChanged(attributes->element(rows[i])->sceneBoundingRect());
+    }
+}
+
+QList<int> Model::updateEdgeRows(const QDomNodeList &netNode, Item *edge)
+{
+    QList<int> rows;
+    for (int j = 0; j < edge->childCount(); ++j)
+    {
+        int row = attributes->findRow(edge->child(j)->xmlNode, edge->child(j)->xmlSubNode);
+        if (row >= 0) rows.append(row);
+    }
+    int edgeRow = attributes->findRow(edge->xmlNode, -1);
+    attributes->setEdge(edgeRow, rows, xmlElement(netNode, edge).attribute("priority"));
+    if (edgeRow >= 0) rows.append(edgeRow);
+    return rows;
 }
 
 void Model::deleteElement(int nodeIndex)
 {
     qDebug() << "Model::deleteElement: nodeIndex=" << QString::number(nodeIndex);
     QDomNode node = domDocument.childNodes().item(netNodeIndex).childNodes().item(nodeIndex).toElement();
+    source->touch(node);
     node.parentNode().removeChild(node);
 
     modified = true;
+    clearQueryTables();
     
     // Emit a signal so that the properties view is updated
     emit attrUpdate(itemSelectionModel->selection(), itemSelectionModel->selection());
@@ -633,9 +1820,11 @@ void Model::deleteElement(int nodeIndex, int subNodeIndex)
 {
     qDebug("Model: deleteElement");
     QDomNode node = domDocument.childNodes().item(netNodeIndex).childNodes().item(nodeIndex).childNodes().item(subNodeIndex).toElement();
+    source->touch(node);
     node.parentNode().removeChild(node);
 
     modified = true;
+    clearQueryTables();
     
     // Emit a signal so that the properties view is updated
     emit attrUpdate(itemSelectionModel->selection(), itemSelectionModel->selection());
@@ -648,8 +1837,15 @@ bool Model::isCaption(Item *item) const
     return item->parent() == rootItem;
 }
 
+void Model::setAnimator(Animator *animator)
+{
+    this->animator = animator;
+}
+
 void Model::highlightHyperlink(QString link) const
 {
+    if (!animator) return;
+
     // Split the link into the prefix and suffix
     QString prefix = link.left(2);
     QString suffix = link.remove(0, 2);
@@ -658,9 +1854,9 @@ void Model::highlightHyperlink(QString link) const
     if (prefix == "1/")  // edge->to or edge->from
     {
         if (rootItem->child(pJuncRow)->child(suffix)->hasPath)
-            rootItem->child(pJuncRow)->child(suffix)->graphicItem1->highlight();
+            animator->blink(rootItem->child(pJuncRow)->child(suffix)->graphicItem1);
         if (rootItem->child(pJuncRow)->child(suffix)->hasPoint)
-            rootItem->child(pJuncRow)->child(suffix)->graphicItem2->highlight();
+            animator->blink(rootItem->child(pJuncRow)->child(suffix)->graphicItem2);
 
         return;
     }
@@ -670,7 +1866,7 @@ void Model::highlightHyperlink(QString link) const
         if (rootItem->child(nEdgeRow)->child(edgeName) != NULL)
             if (rootItem->child(nEdgeRow)->child(edgeName)->child(suffix)->hasPath)
             {
-                rootItem->child(nEdgeRow)->child(edgeName)->child(suffix)->graphicItem1->highlight();
+                animator->blink(rootItem->child(nEdgeRow)->child(edgeName)->child(suffix)->graphicItem1);
                 return;
             }
     }
@@ -680,7 +1876,7 @@ void Model::highlightHyperlink(QString link) const
         if (rootItem->child(iEdgeRow)->child(edgeName) != NULL)
             if (rootItem->child(iEdgeRow)->child(edgeName)->child(suffix)->hasPath)
             {
-                rootItem->child(iEdgeRow)->child(edgeName)->child(suffix)->graphicItem1->highlight();
+                animator->blink(rootItem->child(iEdgeRow)->child(edgeName)->child(suffix)->graphicItem1);
                 return;
             }
     }
@@ -690,7 +1886,7 @@ void Model::highlightHyperlink(QString link) const
         QString id = suffix.left(pointBreak);
         int pointNo = suffix.remove(0, pointBreak + 1).toInt();
         if (rootItem->child(pJuncRow)->child(id)->hasPath)
-            rootItem->child(pJuncRow)->child(id)->graphicItem1->highlightPoint(pointNo);
+            animator->blink(rootItem->child(pJuncRow)->child(id)->graphicItem1, pointNo);
     }
     if (prefix == "6/")  // edge->shape (point in the shape)
     {
@@ -698,7 +1894,7 @@ void Model::highlightHyperlink(QString link) const
         QString id = suffix.left(pointBreak);
         int pointNo = suffix.remove(0, pointBreak + 1).toInt();
         if (rootItem->child(nEdgeRow)->child(id)->hasPath)
-            rootItem->child(nEdgeRow)->child(id)->graphicItem1->highlightPoint(pointNo);
+            animator->blink(rootItem->child(nEdgeRow)->child(id)->graphicItem1, pointNo);
     }
     if (prefix == "7/")  // lane->shape (point in the shape)
     {
@@ -709,19 +1905,19 @@ void Model::highlightHyperlink(QString link) const
         if (rootItem->child(nEdgeRow)->child(edgeName) != NULL)
             if (rootItem->child(nEdgeRow)->child(edgeName)->child(id)->hasPath)
             {
-                rootItem->child(nEdgeRow)->child(edgeName)->child(id)->graphicItem1->highlightPoint(pointNo);
+                animator->blink(rootItem->child(nEdgeRow)->child(edgeName)->child(id)->graphicItem1, pointNo);
                 return;
             }
         if (rootItem->child(iEdgeRow)->child(edgeName) != NULL)
             if (rootItem->child(iEdgeRow)->child(edgeName)->child(id)->hasPath)
             {
-                rootItem->child(iEdgeRow)->child(edgeName)->child(id)->graphicItem1->highlightPoint(pointNo);
+                animator->blink(rootItem->child(iEdgeRow)->child(edgeName)->child(id)->graphicItem1, pointNo);
                 return;
             }
     }
 }
 
-void Model::switchLayerState(TreeBranch branch, bool subbranch, ElementProperty prop, bool state) const
+void Model::switchLayerState(TreeBranch branch, bool subbranch, ElementProperty prop, bool state)
 {
     // Identify the branch number
     int branchNumber;
@@ -750,9 +1946,13 @@ void Model::switchLayerState(TreeBranch branch, bool subbranch, ElementProperty
                 if (rootItem->child(branchNumber)->child(i)->child(j)->hasPath)
                     rootItem->child(branchNumber)->child(i)->child(j)->graphicItem1->switchState(prop, state);
     }
+
+    // The elements leave the redrawing to the caller; the layer covers the whole network
+    if (prop != EditElement)
+        notifyGeometryChanged(QRectF());
 }
 
-void Model::switchPointLayerState(TreeBranch branch, ElementProperty prop, bool state) const
+void Model::switchPointLayerState(TreeBranch branch, ElementProperty prop, bool state)
 {
     // Identify the branch number
     int branchNumber;
@@ -767,6 +1967,10 @@ void Model::switchPointLayerState(TreeBranch branch, ElementProperty prop, bool
     for (int i = 0; i < rootItem->child(branchNumber)->childCount(); ++i)
         if (rootItem->child(branchNumber)->child(i)->hasPoint)
             rootItem->child(branchNumber)->child(i)->graphicItem2->switchState(prop, state);
+
+    // The elements leave the redrawing to the caller; the layer covers the whole network
+    if (prop != EditElement)
+        notifyGeometryChanged(QRectF());
 }
 
 QDomElement Model::getXMLelement(int index, int subindex)
@@ -778,13 +1982,410 @@ QDomElement Model::getXMLelement(int index, int subindex)
         return domDocument.childNodes().at(netNodeIndex).childNodes().at(index).toElement().childNodes().at(subindex).toElement();
 }
 
-void Model::saveTo(QTextStream &textStream)
+bool Model::saveTo(QIODevice *device, QString *errorMessage)
 {
-    // Save the domDocument into the file
-    //stream << model->domDocument.toString();
-    int indent = 4;
-    domDocument.save(textStream, indent);
+    // Stream the domDocument into the device; unlike QDomDocument::save() this neither builds
+    // the whole text in memory nor depends on the hash order of the attributes
+    NetWriter writer;
+    if (!writer.write(domDocument, device, errorMessage))
+        return false;
     modified = false;
+    return true;
+}
+
+bool Model::saveFile(const QString &filePath, QString *errorMessage)
+{
+    QDomElement net = domDocument.childNodes().at(netNodeIndex).toElement();
+    if (source->canSplice())
+    {
+        if (!source->splice(net, filePath, errorMessage))
+            return false;
+        modified = false;
+        return true;
+    }
+
+    // Full save, then index the new file so that the next save can be incremental
+    bool unsaved = modified;
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        if (errorMessage) *errorMessage = file.errorString();
+        return false;
+    }
+    if (!saveTo(&file, errorMessage))
+        return false;
+    if (!file.commit())
+    {
+        modified = unsaved;
+        if (errorMessage) *errorMessage = file.errorString();
+        return false;
+    }
+    source->setFileName(filePath);
+    source->scan(net);
+    return true;
+}
+
+void Model::labelSources(QVector<LabelSource> &sources) const
+{
+    LabelSource source;
+    Item *item;
+    sources.clear();
+
+    // Edges are labelled at the middle of their path
+    for (int i = 0; i < rootItem->child(nEdgeRow)->childCount(); ++i)
+    {
+        item = rootItem->child(nEdgeRow)->child(i);
+        if (!item->hasPath) continue;
+        source.text = item->name;
+        source.anchor = item->graphicItem1->midPoint();
+        source.kind = LabelSource::EdgeLabel;
+        source.extent = item->graphicItem1->pathLength();
+        sources.append(source);
+    }
+
+    // Junctions and traffic lights (which share the graphic elements of their junction) are
+    // labelled at the junction point, or at the centre of the polygon
+    int rows[] = { pJuncRow, tllRow };
+    for (int r = 0; r < 2; ++r)
+        for (int i = 0; i < rootItem->child(rows[r])->childCount(); ++i)
+        {
+            item = rootItem->child(rows[r])->child(i);
+            if (item->hasPoint)
+                source.anchor = item->graphicItem2->rect().center();
+            else if (item->hasPath)
+                source.anchor = item->graphicItem1->boundingRect().center();
+            else
+                continue;
+            source.text = item->name;
+            source.kind = (r == 0 ? LabelSource::JunctionLabel : LabelSource::TLLabel);
+            source.extent = 0;
+            sources.append(source);
+        }
+}
+
+void Model::searchItems(QStringList &ids, QVector<Item*> &items) const
+{
+    ids.clear();
+    items.clear();
+
+    // Requests and phases are numbered within their element, so only their parents are indexed
+    QList<Item*> pending;
+    for (int i = 0; i < rootItem->childCount(); ++i)
+        pending.append(rootItem->child(i));
+    while (!pending.isEmpty())
+    {
+        Item *caption = pending.takeLast();
+        for (int i = 0; i < caption->childCount(); ++i)
+        {
+            Item *item = caption->child(i);
+            if (item->type == Item::Request || item->type == Item::Phase) continue;
+            ids.append(item->name);
+            items.append(item);
+            if (item->childCount() > 0) pending.append(item);
+        }
+    }
+}
+
+AttributeTable *Model::attributeTable() const
+{
+    return attributes;
+}
+
+void Model::setHeatmap(int column, const ColourRamp &ramp, float min, float max)
+{
+    // Colour all the rows in one pass over the column, then hand the colours to the elements
+    QVector<QRgb> colours;
+    if (column >= 0)
+        attributes->colourise(column, ramp, min, max, colours);
+    else
+        colours.fill(0, attributes->rowCount());
+    for (int i = 0; i < colours.count(); ++i)
+        attributes->element(i)->setColourOverride(colours[i]);
+
+    heatColumn = column;
+    heatRamp = ramp;
+    heatMin = min;
+    heatMax = max;
+
+    // Redraw the whole network once
+    notifyGeometryChanged(QRectF());
+}
+
+SnapIndex *Model::snapIndex() const
+{
+    return snap;
+}
+
+void Model::notifyGeometryChanged(const QRectF &rect)
+{
+    if (updateDepth == 0)
+    {
+        emit geometryChanged(rect);
+        return;
+    }
+
+    // Accumulate the area until the update ends; a null rect (the whole network) absorbs the rest
+    if (!pendingGeometry)
+        pendingRect = rect;
+    else if (!pendingRect.isNull())
+        pendingRect = (rect.isNull() ? QRectF() : pendingRect.united(rect));
+    pendingGeometry = true;
+}
+
+void Model::beginUpdate()
+{
+    ++updateDepth;
+}
+
+void Model::endUpdate()
+{
+    if (updateDepth == 0 || --updateDepth > 0) return;
+
+    if (pendingAttr)
+    {
+        pendingAttr = false;
+        emit attrUpdate(itemSelectionModel->selection(), itemSelectionModel->selection());
+    }
+    if (pendingGeometry)
+    {
+        pendingGeometry = false;
+        emit geometryChanged(pendingRect);
+    }
+}
+
+// Plain junctions looked up by id through the id references of their branch in the tree
+class JunctionBranch
+{
+public:
+    explicit JunctionBranch(Item *branch) : branch(branch) {}
+    bool contains(const QString &id) const { return branch->child(id) != 0; }
+    Item *value(const QString &id) const { return branch->child(id); }
+
+private:
+    Item *branch;
+};
+
+void Model::buildTopology()
+{
+    links.clear();
+    turns->clear();
+
+    QList<Item*> items;
+    int rows[] = { pJuncRow, nEdgeRow, iEdgeRow, iJuncRow, connRow };
+    for (int r = 0; r < 5; ++r)
+        for (int i = 0; i < rootItem->child(rows[r])->childCount(); ++i)
+            items.append(rootItem->child(rows[r])->child(i));
+    linkTopology(items);
+}
+
+PathElement *Model::lanePath(const QString &id) const
+{
+    // A lane id is the id of its edge followed by '_index'
+    int separator = id.lastIndexOf('_');
+    if (separator < 0) return 0;
+    Item *edge = rootItem->child(id.startsWith(":") ? iEdgeRow : nEdgeRow)->child(id.left(separator));
+    Item *lane = (edge ? edge->child(id) : 0);
+    return (lane && lane->hasPath ? lane->graphicItem1 : 0);
+}
+
+void Model::linkTopology(const QList<Item*> &items)
+{
+    QDomNodeList netNode = domDocument.childNodes().at(netNodeIndex).childNodes();
+    JunctionBranch junctions(rootItem->child(pJuncRow));
+    Item *pjuncs = rootItem->child(pJuncRow), *ijuncs = rootItem->child(iJuncRow);
+    Item *nedges = rootItem->child(nEdgeRow), *iedges = rootItem->child(iEdgeRow);
+    Item *conns = rootItem->child(connRow);
+
+    // Connections lie within the junction at the end of their 'from' edge. Turns through the
+    // junction start at the connections leaving a normal lane; the rest continue them
+    QHash<QString, Item*> internalConnections;
+    QList<Item*> approaches, owners;
+
+    for (int i = 0; i < items.count(); ++i)
+    {
+        Item *item = items[i];
+        Item *branch = item->parent();
+        if (branch == pjuncs)
+        {
+            if (item->hasPath) links[item].paths.append(item->graphicItem1);
+        }
+        else if (branch == nedges)
+        {
+            // Normal edges start and end at junctions; the end node of the edge and of each lane follows them
+            QDomElement element = netNode.at(item->xmlNode).toElement();
+            Item *from = junctions.value(element.attribute("from"));
+            Item *to = junctions.value(element.attribute("to"));
+            for (int j = -1; j < item->childCount(); ++j)
+            {
+                Item *path = (j < 0 ? item : item->child(j));
+                if (!path->hasPath) continue;
+                if (from) links[from].starts.append(path->graphicItem1);
+                if (to) links[to].ends.append(path->graphicItem1);
+            }
+        }
+        else if (branch == iedges)
+        {
+            // Internal edges and junctions lie within the junction their id starts with
+            Item *owner = junctionOwner(item->name);
+            if (!owner) continue;
+            for (int j = -1; j < item->childCount(); ++j)
+            {
+                Item *path = (j < 0 ? item : item->child(j));
+                if (path->hasPath) links[owner].paths.append(path->graphicItem1);
+            }
+        }
+        else if (branch == ijuncs)
+        {
+            Item *owner = junctionOwner(item->name);
+            if (!owner) continue;
+            if (item->hasPath) links[owner].paths.append(item->graphicItem1);
+            if (item->hasPoint) links[owner].points.append(item->graphicItem2);
+        }
+        else if (branch == conns)
+        {
+            QDomElement element = netNode.at(item->xmlNode).toElement();
+            QString from = element.attribute("from");
+            Item *owner;
+            if (from.startsWith(":"))
+                owner = junctionOwner(from);
+            else
+            {
+                Item *edge = nedges->child(from);
+                owner = (edge ? junctions.value(netNode.at(edge->xmlNode).toElement().attribute("to")) : 0);
+            }
+            if (!owner) continue;
+            if (item->hasPath) links[owner].paths.append(item->graphicItem1);
+            if (item->hasPoint) links[owner].points.append(item->graphicItem2);
+
+            if (from.startsWith(":"))
+                internalConnections.insert(from + QString("_") + element.attribute("fromLane"), item);
+            else
+            {
+                approaches.append(item);
+                owners.append(owner);
+            }
+        }
+    }
+
+    // Each turn runs from the approach lane along the internal lanes of the chained connections
+    // to the departure lane; the internal lanes take consecutive pieces of the curve
+    for (int i = 0; i < approaches.count(); ++i)
+    {
+        QDomElement element = netNode.at(approaches[i]->xmlNode).toElement();
+        TurnGenerator::Turn turn;
+        turn.from = lanePath(element.attribute("from") + QString("_") + element.attribute("fromLane"));
+        turn.to = lanePath(element.attribute("to") + QString("_") + element.attribute("toLane"));
+        if (!turn.from || !turn.to) continue;
+        turn.pieces = 0;
+
+        Item *connection = approaches[i];
+        for (int step = 0; connection && step < maxTurnSteps; ++step)
+        {
+            QString via = netNode.at(connection->xmlNode).toElement().attribute("via");
+            PathElement *lane = (via.isEmpty() ? 0 : lanePath(via));
+            int piece = (lane ? turn.pieces++ : -1);
+            if (lane)
+            {
+                turn.paths.append(lane);
+                turn.piece.append(piece);
+            }
+            if (connection->hasPath)
+            {
+                turn.paths.append(connection->graphicItem1);
+                turn.piece.append(piece);
+            }
+            if (connection->hasPoint) turn.points.append(connection->graphicItem2);
+            connection = (lane ? internalConnections.value(via) : 0);
+        }
+
+        // Without internal lanes the connection takes the whole curve
+        if (turn.pieces == 0)
+        {
+            turn.pieces = 1;
+            for (int j = 0; j < turn.piece.count(); ++j)
+                turn.piece[j] = 0;
+        }
+        turns->addTurn(owners[i], turn);
+    }
+}
+
+void Model::laneEndMoved(PathElement *lane, bool atStart, bool commit)
+{
+    turns->regenerate(lane, atStart, commit);
+}
+
+Item *Model::junctionOwner(const QString &id, const QHash<QString, Item*> &junctions) const
+{
+    return junctions.value(ownerId(id, junctions));
+}
+
+Item *Model::junctionOwner(const QString &id) const
+{
+    JunctionBranch junctions(rootItem->child(pJuncRow));
+    return junctions.value(ownerId(id, junctions));
+}
+
+// Removes the elements of a set from a list
+template <typename T>
+static void removeElements(QList<T*> &list, const QSet<QGraphicsItem*> &elements)
+{
+    for (int i = list.count() - 1; i >= 0; --i)
+        if (elements.contains(list[i])) list.removeAt(i);
+}
+
+void Model::forgetElement(QGraphicsItem *element)
+{
+    forgetElements(QSet<QGraphicsItem*>() << element);
+}
+
+void Model::forgetElements(const QSet<QGraphicsItem*> &elements)
+{
+    QSet<QGraphicsItem*>::const_iterator element;
+    for (element = elements.constBegin(); element != elements.constEnd(); ++element)
+        snap->remove(*element);
+    turns->forget(elements);
+
+    QHash<Item*, JunctionLinks>::iterator it;
+    for (it = links.begin(); it != links.end(); ++it)
+    {
+        removeElements(it->starts, elements);
+        removeElements(it->ends, elements);
+        removeElements(it->paths, elements);
+        removeElements(it->points, elements);
+    }
+}
+
+void Model::moveJunction(Item *junction, const QPointF &delta)
+{
+    // Only the elements attached to the junction are recomputed and repainted
+    QHash<Item*, JunctionLinks>::iterator it = links.find(junction);
+    if (it == links.end()) return;
+
+    for (int i = 0; i < it->starts.count(); ++i)
+        it->starts[i]->follow(delta, PathElement::FirstNode);
+    for (int i = 0; i < it->ends.count(); ++i)
+        it->ends[i]->follow(delta, PathElement::LastNode);
+    for (int i = 0; i < it->paths.count(); ++i)
+        it->paths[i]->follow(delta, PathElement::WholePath);
+    for (int i = 0; i < it->points.count(); ++i)
+        it->points[i]->follow(delta);
+}
+
+void Model::commitJunctionMove(Item *junction)
+{
+    QHash<Item*, JunctionLinks>::iterator it = links.find(junction);
+    if (it == links.end()) return;
+
+    beginUpdate();
+    for (int i = 0; i < it->starts.count(); ++i)
+        it->starts[i]->endFollow();
+    for (int i = 0; i < it->ends.count(); ++i)
+        it->ends[i]->endFollow();
+    for (int i = 0; i < it->paths.count(); ++i)
+        it->paths[i]->endFollow();
+    for (int i = 0; i < it->points.count(); ++i)
+        it->points[i]->endFollow();
+    endUpdate();
 }
 
 bool Model::wasModified() const
@@ -838,7 +2439,9 @@ void Model::deleteEdgeAndLane(Item *item)
     
     qDebug() << "Model: deleteEdgeAndLane, itemSelection after clear: " << itemSelectionModel->selection().indexes().empty();
     //netScene->clearSelection();
+    notifyGeometryChanged(pathit->sceneBoundingRect());
     netScene->removeItem(pathit);
+    forgetElement(pathit);
     // clear mem
     // clear mem creates a problem since we were called from the graphicItem itself
     // and need to be able to return to it.
@@ -866,7 +2469,9 @@ void Model::deleteEdgeAndLane(Item *item)
 
         // if the parent item has a path then remove path from scene
         if ( parent_item->hasPath ) {
+            notifyGeometryChanged(parent_item->graphicItem1->sceneBoundingRect());
             netScene->removeItem(parent_item->graphicItem1);
+            forgetElement(parent_item->graphicItem1);
             // clear mem creates a problem since we were called from the graphicItem itself
             // and need to be able to return to it.
             // Maybe move deleted item to a save place and delete later?
@@ -901,18 +2506,26 @@ void Model::deleteJunction(Item *item)
     if ( item->hasPath ) {
         pathit = item->graphicItem1;
         beginRemoveRows(pathit->model->index(item), item->row(), item->row());
+        notifyGeometryChanged(pathit->sceneBoundingRect());
         netScene->removeItem(pathit);
+        forgetElement(pathit);
         item->parent()->removeChild(item);
         endRemoveRows();
     } 
     if (item->hasPoint) {
         pointit = item->graphicItem2;
         beginRemoveRows(pointit->model->index(item), item->row(), item->row());
+        notifyGeometryChanged(pointit->sceneBoundingRect());
         netScene->removeItem(pointit);
+        forgetElement(pointit);
         item->parent()->removeChild(item);
         endRemoveRows();
     }
     
+    // The elements attached to the junction no longer move with it
+    links.remove(item);
+    turns->removeJunction(item);
+
     // remove from XML structure
     // TODO
     
@@ -934,13 +2547,17 @@ void Model::deleteConnection(Item *item)
     if ( item->hasPath ) {
         pathit = item->graphicItem1;
         beginRemoveRows(pathit->model->index(item), item->row(), item->row());
+        notifyGeometryChanged(pathit->sceneBoundingRect());
         netScene->removeItem(pathit);
+        forgetElement(pathit);
         item->parent()->removeChild(item);
         endRemoveRows();
     } else if (item->hasPoint) {
         pointit = item->graphicItem2;
         beginRemoveRows(pointit->model->index(item), item->row(), item->row());
+        notifyGeometryChanged(pointit->sceneBoundingRect());
         netScene->removeItem(pointit);
+        forgetElement(pointit);
         item->parent()->removeChild(item);
         endRemoveRows();
     } else {
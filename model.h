@@ -22,6 +22,8 @@
 #ifndef MODEL_H
 #define MODEL_H
 
+#include "colourramp.h"
+
 #include <QAbstractItemModel>
 #include <QDomDocument>
 #include <QFile>
@@ -30,9 +32,20 @@
 #include <QItemSelectionModel>
 #include <QIcon>
 #include <QHash>
+#include <QSet>
+#include <QTextStream>
+#include <QTransform>
 
 class Item;
 class PathElement;
+class PointElement;
+class Animator;
+class AttributeTable;
+class SnapIndex;
+class TurnGenerator;
+class QueryTable;
+class NetSource;
+struct LabelSource;
 
 class Model : public QAbstractItemModel
 {
@@ -94,13 +107,34 @@ public:
     // Interprets a link from the Property View and highlights the respective element / point
     void highlightHyperlink(QString link) const;
 
+    // Sets the animator of the network view, used to highlight elements
+    void setAnimator(Animator *animator);
+
+    // Collects the ids of the normal edges, plain junctions and traffic lights with their positions
+    void labelSources(QVector<LabelSource> &sources) const;
+
+    // Collects the ids of the edges, lanes, junctions, connections and traffic lights, and
+    // their items, for the search index
+    void searchItems(QStringList &ids, QVector<Item*> &items) const;
+
+    // Numeric attributes of edges and lanes in columns, filled in when loading the model
+    AttributeTable *attributeTable() const;
+
+    // Colours edges and lanes by a column of the attribute table with a colour ramp, clipping the
+    // values to [min, max]; a column of -1 restores the normal colours
+    void setHeatmap(int column, const ColourRamp &ramp, float min, float max);
+
+    // Points the shape nodes snap to while they are dragged; the elements keep their own
+    // points up to date after an edit
+    SnapIndex *snapIndex() const;
+
     // Returns whether the click item is a caption branch or an element
     bool isCaption(Item *item) const;
 
-    // Switches a property of all elements in a layer
+    // Switches a property of all elements in a layer, refreshing the drawing of the network once
     // Called by the Controls View
-    void switchLayerState(TreeBranch branch, bool subbranch, Model::ElementProperty prop, bool state) const;
-    void switchPointLayerState(TreeBranch branch, Model::ElementProperty prop, bool state) const;
+    void switchLayerState(TreeBranch branch, bool subbranch, Model::ElementProperty prop, bool state);
+    void switchPointLayerState(TreeBranch branch, Model::ElementProperty prop, bool state);
 
     // used internally when loading model, and by TLEditor
     Item* getJunction(QString id) const;
@@ -115,19 +149,100 @@ public:
     // Delete Connection from scene, the model and the XML SUMO network
     void deleteConnection(Item *item);
     
-    // Save domDocument into a file stream
-    void saveTo(QTextStream &textStream);
+    // Save domDocument into a file or other device, streaming it with NetWriter
+    // Returns false and fills in 'errorMessage' if the device could not be written
+    bool saveTo(QIODevice *device, QString *errorMessage = 0);
+
+    // Save domDocument into 'filePath'. When possible only the elements changed, inserted or
+    // removed since the last save are written, spliced into a copy of the file they were read
+    // from; otherwise the whole document is streamed. The file is replaced atomically
+    // Returns false and fills in 'errorMessage' if the file could not be written
+    bool saveFile(const QString &filePath, QString *errorMessage = 0);
+
+    // Reports that the drawing of the network changed within 'rect' (in scene coordinates);
+    // called by the graphic elements after an edit and when elements are removed or hidden
+    void notifyGeometryChanged(const QRectF &rect);
+
+    // Groups several edits into one update: the attribute and geometry signals are held back
+    // until the outermost endUpdate() and then emitted once. Calls can be nested
+    void beginUpdate();
+    void endUpdate();
+
+    // Moves the elements attached to a plain junction (lane and edge ends, junction polygon,
+    // internal lanes and junctions, connections) while the junction point is dragged
+    void moveJunction(Item *junction, const QPointF &delta);
+
+    // Writes the geometry of the elements moved with a junction into the XML domDocument as one update
+    void commitJunctionMove(Item *junction);
+
+    // Regenerates in the background the internal lanes and connections of the junction at the
+    // start or end of a lane whose end node moved; with 'commit' they are also written into the
+    // XML domDocument. Called by the lane while its end node is dragged and when it is released
+    void laneEndMoved(PathElement *lane, bool atStart, bool commit);
+
+    // Elements selected in the network view with a rectangle or a lasso. This selection is kept apart
+    // from the tree selection, so that tens of thousands of elements can be selected at once
+    const QList<Item*> &selectedElements() const;
+    void clearElementSelection();
+
+    // Bulk operations on the element selection: deleting the elements, setting an attribute on all
+    // of them, showing or hiding them, and writing their XML elements as a network subset with
+    // NetWriter, which returns false and fills in 'errorMessage' if the device could not be written
+    void deleteSelection();
+    void setSelectionAttribute(const QString &attr, const QString &value);
+    void setSelectionVisible(bool visible);
+    bool selectionVisible() const;
+    bool exportSelection(QIODevice *device, QString *errorMessage = 0) const;
+
+    // Reads attributes over the whole element selection in one pass: the value shared by all the
+    // elements, or an empty value and 'mixed' set if they differ
+    void selectionAttributes(const QStringList &attrs, QStringList &values, QList<bool> &mixed) const;
+
+    // Copies the XML elements of the element selection, together with the internal edges and junctions
+    // and the traffic lights of the selected junctions, and the connections between the copied edges
+    void copySelection();
+    bool canPaste() const;
+
+    // Adds the copied elements to the network shifted by 'offset', in one batch; the elements get new
+    // ids, and the references between them (from, to, incLanes, intLanes, via, tl) follow the new ids.
+    // The pasted elements become the element selection
+    void paste(const QPointF &offset);
+
+    // Applies an affine transform to the shape nodes and junction points of the element selection, or
+    // of the whole network when nothing is selected, in one pass over their coordinates; the XML
+    // domDocument and the scene are updated in one batch, and <location> too for the whole network
+    void transformElements(const QTransform &transform);
+
+    // Bounding rectangle of the element selection, or of the whole network
+    QRectF elementsBounds() const;
+
+    // Measures all the lanes in parallel and writes the length of those differing from their
+    // 'length' attribute by more than 'tolerance' metres, in one batch; returns the number written
+    int recomputeLengths(qreal tolerance);
+
+    // Selects the elements matching an attribute query, e.g. junction.type == "traffic_light" and
+    // degree > 4; returns false and sets 'error' if the query is not valid
+    bool selectByQuery(const QString &text, QString &error);
 
 public slots:
     // Calls deselect() of the 'off' graphic items and select() of the 'on' graphic items
     void selectionChanged(QItemSelection on, QItemSelection off);
 
+    // Replaces the element selection, clearing the tree selection
+    void selectElements(QList<Item*> items);
+
 signals:
     // Emitted by loadModel() to inform the status of the loading process in the status bar
     void statusUpdate(QString msg);
 
     // Emitted by editAttribute() so that the properties and edit views are updated
     void attrUpdate(QItemSelection on, QItemSelection off);
+
+    // Emitted by notifyGeometryChanged(); a null rect means the whole network
+    void geometryChanged(QRectF rect);
+
+    // Emitted when the element selection changes
+    void elementSelectionChanged(int count);
     
 private:
     // Root item from where 'Plain Junctions', 'Internal Junctions', 'Normal Edges',
@@ -144,6 +259,10 @@ private:
     // Stores if the model has been modified after last saved
     bool modified;
 
+    // Byte ranges of the elements in the file last loaded or saved, and the elements edited
+    // since; every change to domDocument must be reported to it with touch()
+    NetSource *source;
+
     // Holds the result of QDomDocument.setContent in the constructor
     // true if the XML data was parsed successfully, false otherwise
     bool domDocContentSet;
@@ -154,11 +273,104 @@ private:
     // Pointer to the Selection Model of the Main Window
     QItemSelectionModel *itemSelectionModel;
 
-    // Loading procedures
-    void loadJunctions();
-    void loadEdgesAndLanes();
-    void loadConnections();
-    void loadSignals();
+    // Pointer to the animator of the network view; highlighting is disabled without it
+    Animator *animator;
+
+    // Attribute columns and the current heatmap (column -1 when off)
+    AttributeTable *attributes;
+    int heatColumn;
+    ColourRamp heatRamp;
+    float heatMin, heatMax;
+
+    // Spatial index of the shape vertices and junction points, built when loading the model
+    SnapIndex *snap;
+
+    // Elements attached to a plain junction: paths whose first or last node sits at the junction,
+    // and paths and points that lie within it
+    struct JunctionLinks
+    {
+        QList<PathElement*> starts, ends, paths;
+        QList<PointElement*> points;
+    };
+    QHash<Item*, JunctionLinks> links;
+
+    // Turns through the junctions, regenerated when their lanes change
+    TurnGenerator *turns;
+
+    // Longest chain of connections followed to build a turn
+    static const int maxTurnSteps = 8;
+
+    // Attribute columns of each type of element for the queries, built on first use, updated in
+    // place when an attribute is edited and dropped when elements are added, deleted or transformed
+    QHash<int, QueryTable*> queryTables;
+    QueryTable *queryTable(int type);
+    void clearQueryTables();
+
+    // Keeps the query tables in step with an edited attribute
+    void updateQueryTables(int node, int subNode, const QString &attr, const QString &value);
+
+    // Fills in the junction links and the turns from the edge, internal junction and connection elements
+    void buildTopology();
+
+    // Adds the links and turns of the given junctions, edges and connections to the existing ones,
+    // e.g. for pasted elements; the elements they refer to are looked up through the tree
+    void linkTopology(const QList<Item*> &items);
+
+    // Path Element of a lane, from its id; 0 if there is none
+    PathElement *lanePath(const QString &id) const;
+
+    // Plain junction an internal element belongs to, from its id (":junction_index"), among the
+    // given junctions or all the plain junctions of the network
+    Item *junctionOwner(const QString &id, const QHash<QString, Item*> &junctions) const;
+    Item *junctionOwner(const QString &id) const;
+
+    // Takes removed elements out of the snap index, the turns and the junction links
+    void forgetElement(QGraphicsItem *element);
+    void forgetElements(const QSet<QGraphicsItem*> &elements);
+
+    // Element selection
+    QList<Item*> elementSelection;
+
+    // Copied XML elements, detached from the <net> node
+    QList<QDomElement> clipboard;
+
+    // Shifts the points of a 'shape' attribute
+    static QString shiftShape(const QString &shape, const QPointF &offset);
+
+    // Items transformed by transformElements(): the element selection, or all the elements
+    QList<Item*> transformedItems() const;
+
+    // Selects or deselects the graphic elements of an item
+    void selectGraphics(Item *item, bool on) const;
+
+    // XML element of an item, from the list of <net> child nodes
+    QDomElement xmlElement(const QDomNodeList &netNode, const Item *item) const;
+
+    // Keeps the attribute table and the heatmap in step with an edited attribute
+    void updateAttributeTable(const QDomNodeList &netNode, int node, int subNode, const QString &attr, const QString &value);
+
+    // Fills in the values an edge and its lanes take from each other in the attribute table;
+    // returns the rows of the lanes and of the edge
+    QList<int> updateEdgeRows(const QDomNodeList &netNode, Item *edge);
+
+    // Shifts the XML indices of the items after nodes and subnodes have been removed from the
+    // XML domDocument; 'removedNodes' and the lists in 'removedSubNodes' are sorted
+    void renumberXML(Item *item, const QVector<int> &removedNodes, const QHash<int, QVector<int> > &removedSubNodes);
+
+    // Links the graphic elements to the model indices of their items again after rows were removed
+    void refreshIndexes();
+
+    // Nesting level of beginUpdate() and the signals held back meanwhile
+    int updateDepth;
+    bool pendingAttr, pendingGeometry;
+    QRectF pendingRect;
+
+    // Loading procedures; elements are loaded from the <net> child node 'first' on, so that
+    // pasted elements are added after the others
+    void loadJunctions(int first = 0);
+    void loadEdgesAndLanes(int first = 0);
+    void loadConnections(int first = 0);
+    void loadSignals(int first = 0);
 
     // Aiding functions of the loading procedures
     QString getLanePath(QString id) const;
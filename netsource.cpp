@@ -0,0 +1,417 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#include "netsource.h"
+#include "netwriter.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QBuffer>
+#include <QXmlStreamWriter>
+
+#include <string.h>
+
+// Output of a splice: the copies from the source file are held back and merged while they
+// are contiguous, so that a run of untouched elements is written with one call
+class SpliceOutput
+{
+public:
+    SpliceOutput(QIODevice *device, const char *source) :
+        device(device), source(source), from(0), to(0), written(0), failed(false) {}
+
+    void copy(qint64 start, qint64 end)
+    {
+        if (start >= end) return;
+        if (start != to) flush();
+        if (from == to) from = start;
+        to = end;
+    }
+
+    void write(const QByteArray &text)
+    {
+        flush();
+        if (!failed && device->write(text) != text.size()) failed = true;
+        written += text.size();
+    }
+
+    bool flush()
+    {
+        if (from < to && !failed && device->write(source + from, to - from) != to - from) failed = true;
+        written += to - from;
+        from = to = 0;
+        return !failed;
+    }
+
+    // Bytes written so far, including the copy held back
+    qint64 position() const { return written + to - from; }
+
+private:
+    QIODevice *device;
+    const char *source;
+    qint64 from, to, written;
+    bool failed;
+};
+
+// Copies the text before a removed element, data[gapStart, elementStart): comments are kept,
+// the whitespace leading up to the element is dropped with it
+static void copyRemoved(SpliceOutput &out, const char *data, qint64 gapStart, qint64 elementStart)
+{
+    qint64 end = elementStart;
+    while (end > gapStart && (data[end - 1] == ' ' || data[end - 1] == '\t' || data[end - 1] == '\r' || data[end - 1] == '\n'))
+        --end;
+    out.copy(gapStart, end);
+}
+
+// Position of 'pattern' in data[from, size), or -1. The files may be larger than a QByteArray can index
+static qint64 find(const char *data, qint64 size, qint64 from, const char *pattern)
+{
+    qint64 length = qstrlen(pattern);
+    while (from + length <= size)
+    {
+        const char *match = static_cast<const char*>(memchr(data + from, pattern[0], size - from));
+        if (!match) return -1;
+        from = match - data;
+        if (from + length <= size && memcmp(match, pattern, length) == 0) return from;
+        ++from;
+    }
+    return -1;
+}
+
+// Returns if data[i, size) begins with 'pattern'
+static bool startsWith(const char *data, qint64 size, qint64 i, const char *pattern)
+{
+    qint64 length = qstrlen(pattern);
+    return i + length <= size && memcmp(data + i, pattern, length) == 0;
+}
+
+NetSource::NetSource(const QString &fileName) : file(fileName)
+{
+    clear();
+}
+
+void NetSource::setFileName(const QString &fileName)
+{
+    file = fileName;
+    clear();
+}
+
+QString NetSource::fileName() const
+{
+    return file;
+}
+
+void NetSource::clear()
+{
+    valid = false;
+    rootTouched = false;
+    fileSize = -1;
+    contentStart = 0;
+    root = QDomNode();
+    nodes.clear();
+    starts.clear();
+    ends.clear();
+    positions.clear();
+    touched.clear();
+}
+
+qint64 NetSource::keyOf(const QDomNode &node)
+{
+    if (node.lineNumber() < 0 || node.columnNumber() < 0) return -1;
+    return (qint64(node.lineNumber()) << 32) | qint64(node.columnNumber());
+}
+
+int NetSource::position(const QDomNode &node) const
+{
+    qint64 key = keyOf(node);
+    if (key < 0) return -1;
+    int k = positions.value(key, -1);
+    return (k >= 0 && nodes[k] == node) ? k : -1;
+}
+
+bool NetSource::scan(const QDomElement &root)
+{
+    clear();
+    QFile input(file);
+    if (!input.open(QIODevice::ReadOnly)) return false;
+    qint64 size = input.size();
+    uchar *map = input.map(0, size);
+    if (!map) return false;
+    const char *data = reinterpret_cast<const char*>(map);
+
+    // Byte ranges are only meaningful if new text can be written in the same encoding
+    if (startsWith(data, size, 0, "\xFF\xFE") || startsWith(data, size, 0, "\xFE\xFF")) return false;
+
+    // Walk the markup, keeping track of the depth: the elements found at depth 1 are the
+    // children of <net>. Comments, CDATA and processing instructions are skipped whole
+    int depth = 0;
+    qint64 i = 0;
+    while (true)
+    {
+        i = find(data, size, i, "<");
+        if (i < 0) break;
+        if (i + 1 >= size) return false;
+        qint64 end;
+        if (data[i + 1] == '?')
+        {
+            end = find(data, size, i, "?>");
+            if (end < 0) return false;
+            QByteArray instruction = QByteArray(data + i, end - i).toLower();
+            if (depth == 0 && instruction.startsWith("<?xml ") && instruction.contains("encoding")
+                    && !instruction.contains("utf-8"))
+                return false;
+            i = end + 2;
+        }
+        else if (startsWith(data, size, i, "<!--"))
+        {
+            end = find(data, size, i, "-->");
+            if (end < 0) return false;
+            i = end + 3;
+        }
+        else if (startsWith(data, size, i, "<![CDATA["))
+        {
+            end = find(data, size, i, "]]>");
+            if (end < 0) return false;
+            i = end + 3;
+        }
+        else if (data[i + 1] == '!')
+        {
+            // Document type declaration, possibly with an internal subset in brackets
+            int brackets = 0;
+            for (end = i + 2; end < size; ++end)
+            {
+                char c = data[end];
+                if (c == '[') ++brackets;
+                else if (c == ']') --brackets;
+                else if (c == '>' && brackets == 0) break;
+            }
+            if (end >= size) return false;
+            i = end + 1;
+        }
+        else if (data[i + 1] == '/')
+        {
+            end = find(data, size, i, ">");
+            if (end < 0 || depth == 0) return false;
+            if (--depth == 1) ends.append(end + 1);
+            i = end + 1;
+            if (depth == 0) break;
+        }
+        else
+        {
+            // Start tag; '>' may appear inside quoted attribute values
+            char quote = 0;
+            for (end = i + 1; end < size; ++end)
+            {
+                char c = data[end];
+                if (quote) { if (c == quote) quote = 0; }
+                else if (c == '"' || c == '\'') quote = c;
+                else if (c == '>') break;
+            }
+            if (end >= size) return false;
+            bool empty = (data[end - 1] == '/');
+            if (depth == 0)
+            {
+                if (empty) return false;
+                contentStart = end + 1;
+            }
+            else if (depth == 1)
+            {
+                starts.append(i);
+                if (empty) ends.append(end + 1);
+            }
+            if (!empty) ++depth;
+            i = end + 1;
+        }
+    }
+    input.unmap(map);
+
+    // The ranges must pair up with the child elements of the document, in order
+    for (QDomElement element = root.firstChildElement(); !element.isNull(); element = element.nextSiblingElement())
+        nodes.append(element);
+    if (depth != 0 || starts.count() != ends.count() || starts.count() != nodes.count())
+    {
+        clear();
+        return false;
+    }
+
+    this->root = root;
+    QFileInfo info(file);
+    fileSize = info.size();
+    fileModified = info.lastModified();
+    index();
+    valid = true;
+    return true;
+}
+
+void NetSource::index()
+{
+    positions.clear();
+    positions.reserve(nodes.count());
+    for (int i = 0; i < nodes.count(); ++i)
+    {
+        qint64 key = keyOf(nodes[i]);
+        if (key >= 0) positions.insert(key, i);
+    }
+    touched.clear();
+    rootTouched = false;
+}
+
+void NetSource::touch(const QDomNode &node)
+{
+    if (!valid) return;
+
+    // Climb to the child of <net>; its subtree is written as a whole
+    QDomNode element = node;
+    if (element == root)
+    {
+        rootTouched = true;
+        return;
+    }
+    while (!element.isNull() && element.parentNode() != root)
+        element = element.parentNode();
+    int k = (element.isNull() ? -1 : position(element));
+    if (k >= 0) touched.insert(k);
+}
+
+bool NetSource::canSplice() const
+{
+    if (!valid || rootTouched) return false;
+    QFileInfo info(file);
+    return info.exists() && info.size() == fileSize && info.lastModified() == fileModified;
+}
+
+QByteArray NetSource::elementText(NetWriter &writer, const QDomElement &element, const QByteArray &indentation)
+{
+    QByteArray text;
+    QBuffer buffer(&text);
+    buffer.open(QIODevice::WriteOnly);
+    QXmlStreamWriter xml(&buffer);
+    xml.setAutoFormatting(true);
+    xml.setAutoFormattingIndent(NetWriter::indent);
+    writer.writeElement(xml, element);
+    xml.writeEndDocument();
+    buffer.close();
+
+    // The writer indents from column 0; shift the nested lines to the element's column
+    text = text.trimmed();
+    text.replace('\n', "\n" + indentation);
+    return text;
+}
+
+bool NetSource::splice(const QDomElement &root, const QString &target, QString *errorMessage)
+{
+    QFile input(file);
+    if (!input.open(QIODevice::ReadOnly))
+    {
+        if (errorMessage) *errorMessage = input.errorString();
+        return false;
+    }
+    qint64 size = input.size();
+    uchar *map = input.map(0, size);
+    if (!map)
+    {
+        if (errorMessage) *errorMessage = input.errorString();
+        return false;
+    }
+    const char *data = reinterpret_cast<const char*>(map);
+
+    QSaveFile output(target);
+    if (!output.open(QIODevice::WriteOnly))
+    {
+        if (errorMessage) *errorMessage = output.errorString();
+        return false;
+    }
+
+    // The declaration and the <net> start tag are kept as they are
+    NetWriter writer;
+    SpliceOutput out(&output, data);
+    out.copy(0, contentStart);
+
+    QList<QDomNode> newNodes;
+    QVector<qint64> newStarts, newEnds;
+    newNodes.reserve(nodes.count());
+    newStarts.reserve(nodes.count());
+    newEnds.reserve(nodes.count());
+    QByteArray indentation(NetWriter::indent, ' ');
+    int next = 0;
+    for (QDomElement element = root.firstChildElement(); !element.isNull(); element = element.nextSiblingElement())
+    {
+        // Elements of the file are copied in file order; one found before an element already
+        // copied has been moved, and is written anew like an inserted one
+        int k = position(element);
+        if (k < next) k = -1;
+
+        // An element from the file keeps the text before it, which may hold comments; an
+        // inserted one goes on a new line with the indentation of the element before it
+        if (k >= 0)
+        {
+            for (; next < k; ++next)
+                copyRemoved(out, data, next > 0 ? ends[next - 1] : contentStart, starts[next]);
+            next = k + 1;
+            qint64 gapStart = (k > 0 ? ends[k - 1] : contentStart);
+            out.copy(gapStart, starts[k]);
+            qint64 lineStart = starts[k];
+            while (lineStart > gapStart && data[lineStart - 1] != '\n')
+                --lineStart;
+            if (lineStart > gapStart)
+            {
+                QByteArray line(data + lineStart, starts[k] - lineStart);
+                if (line.trimmed().isEmpty()) indentation = line;
+            }
+        }
+        else
+            out.write("\n" + indentation);
+
+        newStarts.append(out.position());
+        if (k >= 0 && !touched.contains(k))
+            out.copy(starts[k], ends[k]);
+        else
+            out.write(elementText(writer, element, indentation));
+        newEnds.append(out.position());
+        newNodes.append(element);
+    }
+
+    // The rest of the file after the last element, with the </net> end tag
+    for (; next < nodes.count(); ++next)
+        copyRemoved(out, data, next > 0 ? ends[next - 1] : contentStart, starts[next]);
+    out.copy(ends.isEmpty() ? contentStart : ends.last(), size);
+    bool written = out.flush();
+
+    // The source must be released before it is replaced
+    input.unmap(map);
+    input.close();
+    if (!written || !output.commit())
+    {
+        if (errorMessage) *errorMessage = output.errorString();
+        return false;
+    }
+
+    // The index now describes the new file
+    file = target;
+    nodes = newNodes;
+    starts = newStarts;
+    ends = newEnds;
+    QFileInfo info(file);
+    fileSize = info.size();
+    fileModified = info.lastModified();
+    index();
+    return true;
+}
@@ -0,0 +1,99 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#ifndef NETSOURCE_H
+#define NETSOURCE_H
+
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QDateTime>
+#include <QDomNode>
+#include <QDomElement>
+
+class NetWriter;
+
+class NetSource
+{
+public:
+    // 'fileName' is the network file the document was read from
+    explicit NetSource(const QString &fileName);
+
+    // Finds where each child element of 'root' (the <net> element) lies in the file, so that
+    // later saves can copy the untouched ones byte for byte. Returns false, and disables the
+    // incremental saves, if the file cannot be mapped, is not UTF-8 or does not match the document
+    bool scan(const QDomElement &root);
+
+    // Changes the file the document is taken to come from; scan() must be called afterwards
+    void setFileName(const QString &fileName);
+    QString fileName() const;
+
+    // Records that 'node' changed; the child of <net> it belongs to will be written anew.
+    // Inserted and removed elements need not be reported, they are found when saving
+    void touch(const QDomNode &node);
+
+    // Returns if save() can patch the file, that is, it was indexed, <net> itself was not
+    // edited and nobody else changed the file since
+    bool canSplice() const;
+
+    // Writes 'root' into 'target' by copying the file and splicing in new text for the changed
+    // and inserted elements; removed elements are left out with the whitespace before them, but
+    // not the comments. 'target' may be the file itself, as it is replaced atomically. The index
+    // then describes 'target'
+    // Returns false and fills in 'errorMessage' if the file could not be written
+    bool splice(const QDomElement &root, const QString &target, QString *errorMessage = 0);
+
+private:
+    // Key of a node read from a file: the line and column the parser found it at, or -1 for a
+    // node created afterwards. Only a hint, since a copy of a node may carry the same position
+    static qint64 keyOf(const QDomNode &node);
+
+    // Position of a child of <net> in 'nodes', or -1 if it was not read from the file
+    int position(const QDomNode &node) const;
+
+    // Text of a changed or inserted element, indented by 'indentation'
+    static QByteArray elementText(NetWriter &writer, const QDomElement &element, const QByteArray &indentation);
+
+    void clear();
+    void index();
+
+    QString file;
+    qint64 fileSize;
+    QDateTime fileModified;
+    bool valid;
+    bool rootTouched;
+
+    // Children of <net> in file order, with the byte range of each one. 'contentStart' is just
+    // after the <net> start tag; the text between the elements belongs to the element after it
+    QDomNode root;
+    QList<QDomNode> nodes;
+    QVector<qint64> starts, ends;
+    qint64 contentStart;
+
+    // Position of each node in 'nodes' by its key, and the positions of the nodes touched since
+    // the last save. Nodes inserted after loading have no key: they are written anew every time
+    QHash<qint64, int> positions;
+    QSet<int> touched;
+};
+
+#endif // NETSOURCE_H
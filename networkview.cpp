@@ -23,9 +23,19 @@
 #include "pathelement.h"
 #include "pointelement.h"
 #include "item.h"
+#include "snapindex.h"
 
 #include <QMouseEvent>
+#include <QPaintEvent>
+#include <QResizeEvent>
 #include <QMessageBox>
+#include <QElapsedTimer>
+#include <QPainter>
+#include <QLineF>
+#include <QSet>
+#include <QHash>
+#include <QtAlgorithms>
+#include <QStyleOptionGraphicsItem>
 #include <qmath.h>
 #include <QDebug>
 
@@ -41,6 +51,247 @@ NetworkView::NetworkView() : QGraphicsView()
     zoom = 0;
     itemsLastClick = 0;
     currentIndex = 0;
+    selecting = NoSelection;
+
+    // Create the rendering statistics overlay on top of the viewport, hidden by default
+    statsOverlay = new StatsOverlay(this);
+    statsOverlay->move(8, 8);
+    statsOverlay->hide();
+    for (int i = 0; i < PaintStats::CategoryCount; ++i)
+        itemTotals[i] = 0;
+    itemTotalsValid = false;
+    frameIndexNs = 0;
+    frameCandidates = 0;
+
+    elementAnimator = new Animator(this);
+    labels = new LabelLayer(this);
+    connect(labels, SIGNAL(updateNeeded()), viewport(), SLOT(update()));
+
+    // The static network is kept in the background cache, so selecting, highlighting and
+    // editing an element only repaints that element over it
+    setCacheMode(QGraphicsView::CacheBackground);
+
+    // Progressive rendering: antialiased when idle, fast while panning and zooming
+    setRenderHint(QPainter::Antialiasing, true);
+    interacting = false;
+    refineStrip = 0;
+    idleTimer.setSingleShot(true);
+    idleTimer.setInterval(idleDelay);
+    connect(&idleTimer, SIGNAL(timeout()), this, SLOT(startRefine()));
+    refineTimer.setInterval(0);
+    connect(&refineTimer, SIGNAL(timeout()), this, SLOT(refineStep()));
+
+    hoverButtons = false;
+    hoverTimer.setSingleShot(true);
+    hoverTimer.setInterval(hoverInterval);
+    connect(&hoverTimer, SIGNAL(timeout()), this, SLOT(updateHover()));
+}
+
+// Path Elements and Point Elements keep the type() of QGraphicsPathItem and QGraphicsEllipseItem,
+// since their 'type' member hides the function. Items of other types are rejected by the type
+// alone; the cast only confirms path and ellipse items, which labels or overlays could also be
+static bool elementOf(QGraphicsItem *graphic, PathElement *&path, PointElement *&point)
+{
+    path = 0;
+    point = 0;
+    if (graphic->type() == QGraphicsPathItem::Type)
+        path = dynamic_cast<PathElement*>(graphic);
+    else if (graphic->type() == QGraphicsEllipseItem::Type)
+        point = dynamic_cast<PointElement*>(graphic);
+    return (path || point);
+}
+
+void NetworkView::beginInteraction()
+{
+    if (!interacting)
+    {
+        interacting = true;
+        setRenderHint(QPainter::Antialiasing, false);
+    }
+
+    // Stop the full quality pass and wait for the input to be idle again
+    refineTimer.stop();
+    idleTimer.start();
+}
+
+void NetworkView::startRefine()
+{
+    interacting = false;
+    setRenderHint(QPainter::Antialiasing, true);
+    refineStrip = 0;
+    refineTimer.start();
+}
+
+void NetworkView::refineStep()
+{
+    // Redraw one strip of the background per event loop iteration, so that input events
+    // are processed between strips and can interrupt the pass
+    QRect strip(0, refineStrip * stripHeight, viewport()->width(), stripHeight);
+    if (!scene() || strip.top() >= viewport()->height())
+    {
+        refineTimer.stop();
+        return;
+    }
+    scene()->invalidate(mapToScene(strip).boundingRect(), QGraphicsScene::BackgroundLayer);
+    viewport()->repaint(strip);
+    ++refineStrip;
+}
+
+void NetworkView::drawBackground(QPainter *painter, const QRectF &rect)
+{
+    QGraphicsView::drawBackground(painter, rect);
+    if (!scene()) return;
+
+    // Paint all the visible elements in the region with their normal style, except the ones being dragged;
+    // no widget is passed so that the elements know it is the background pass
+    QElapsedTimer query;
+    if (PaintStats::enabled) query.start();
+    QList<QGraphicsItem *> rectItems = scene()->items(rect, Qt::IntersectsItemBoundingRect, Qt::AscendingOrder);
+    if (PaintStats::enabled)
+    {
+        frameIndexNs += query.nsecsElapsed();
+        frameCandidates += rectItems.count();
+    }
+    QStyleOptionGraphicsItem option;
+    PathElement *pathit;
+    PointElement *pointit;
+    QElapsedTimer budget;
+    budget.start();
+    PathElement::setLowDetail(interacting);
+    for (int i = 0; i < rectItems.count(); ++i)
+    {
+        // While interacting, lanes (lowest in the stacking order) come first and the rest is left
+        // for the full quality pass once the frame budget is spent; points are left out altogether
+        if (interacting && budget.elapsed() > frameBudget) break;
+        if (!rectItems[i]->isVisible()) continue;
+        pathit = dynamic_cast <PathElement*>(rectItems[i]);
+        if (pathit != NULL && pathit->isMoving()) continue;
+        pointit = dynamic_cast <PointElement*>(rectItems[i]);
+        if (pointit != NULL && (interacting || pointit->isMoving())) continue;
+
+        painter->save();
+        painter->setTransform(rectItems[i]->sceneTransform(), true);
+        option.exposedRect = rectItems[i]->boundingRect();
+        rectItems[i]->paint(painter, &option, 0);
+        painter->restore();
+    }
+    PathElement::setLowDetail(false);
+}
+
+void NetworkView::invalidateBackground(QRectF rect)
+{
+    itemTotalsValid = false;
+    if (rect.isNull())
+        resetCachedContent();
+    else if (scene())
+        scene()->invalidate(rect, QGraphicsScene::BackgroundLayer);
+}
+
+Animator *NetworkView::animator() const
+{
+    return elementAnimator;
+}
+
+LabelLayer *NetworkView::labelLayer() const
+{
+    return labels;
+}
+
+void NetworkView::drawForeground(QPainter *painter, const QRectF &rect)
+{
+    QGraphicsView::drawForeground(painter, rect);
+    labels->paint(painter, viewportTransform(), viewport()->rect());
+
+    // Selection rectangle or lasso, with a cosmetic pen
+    if (selecting != NoSelection && selectionPolygon.count() > 1)
+    {
+        painter->save();
+        painter->setPen(QPen(QColor(0, 120, 215), 0, Qt::DashLine));
+        painter->setBrush(QColor(0, 120, 215, 40));
+        painter->drawPolygon(selectionPolygon);
+        painter->restore();
+    }
+}
+
+void NetworkView::paintEvent(QPaintEvent *event)
+{
+    if (!PaintStats::enabled || !scene())
+    {
+        QGraphicsView::paintEvent(event);
+        return;
+    }
+
+    // Time the frame and count the paint() calls made during it; drawBackground() times its own
+    // index queries
+    if (!itemTotalsValid) countItems();
+    PaintStats::reset();
+    frameIndexNs = 0;
+    frameCandidates = 0;
+    QElapsedTimer timer;
+    timer.start();
+    QGraphicsView::paintEvent(event);
+    qreal frameMs = timer.nsecsElapsed() / 1e6;
+
+    statsOverlay->addFrame(frameMs, frameIndexNs / 1e6, frameCandidates, itemTotals);
+}
+
+void NetworkView::showStats(bool show)
+{
+    if (show)
+    {
+        countItems();
+        statsOverlay->show();
+        statsOverlay->raise();
+    }
+    else
+        statsOverlay->hide();
+    updateStatsEnabled();
+    viewport()->update();
+}
+
+bool NetworkView::startStatsLog(const QString &fileName)
+{
+    countItems();
+    bool started = statsOverlay->startLog(fileName);
+    updateStatsEnabled();
+    return started;
+}
+
+void NetworkView::stopStatsLog()
+{
+    statsOverlay->stopLog();
+    updateStatsEnabled();
+}
+
+void NetworkView::updateStatsEnabled()
+{
+    PaintStats::enabled = statsOverlay->isVisible() || statsOverlay->isLogging();
+}
+
+void NetworkView::countItems()
+{
+    for (int i = 0; i < PaintStats::CategoryCount; ++i)
+        itemTotals[i] = 0;
+    if (!scene()) return;
+    itemTotalsValid = true;
+
+    // Count the visible items per category; the difference with the paint() calls are the culled items
+    QList<QGraphicsItem *> allItems = scene()->items();
+    PathElement *pathit;
+    PointElement *pointit;
+    for (int i = 0; i < allItems.count(); ++i)
+    {
+        if (!allItems[i]->isVisible()) continue;
+        pathit = dynamic_cast <PathElement*>(allItems[i]);
+        if (pathit != NULL)
+            ++itemTotals[pathit->paintCategory()];
+        else
+        {
+            pointit = dynamic_cast <PointElement*>(allItems[i]);
+            if (pointit != NULL)
+                ++itemTotals[pointit->paintCategory()];
+        }
+    }
 }
 
 void NetworkView::wheelEvent(QWheelEvent *event)
@@ -51,13 +302,7 @@ void NetworkView::wheelEvent(QWheelEvent *event)
     // Increase or decrease zoom depending on wheel direction
     if (event->delta() > 0) zoom += 0.5; else zoom -= 0.5;
 
-    qreal scale = qExp(zoom);
-
-    // Adjust matrix accordingly; yScale is multiplied by -1 given
-    // the Graphics View coordinates are in the opposite direction
-    QMatrix matrix;
-    matrix.scale(scale, -scale);
-    setMatrix(matrix);
+    applyZoom();
 }
 
 void NetworkView::zoomExtents()
@@ -68,34 +313,43 @@ void NetworkView::zoomExtents()
     else
         zoom = qLn(height() / scene()->height());
 
-    qreal scale = qExp(zoom);
-
-    // Adjust matrix accordingly; yScale is multiplied by -1 given
-    // the Graphics View coordinates are in the opposite direction
-    QMatrix matrix;
-    matrix.scale(scale, -scale);
-    setMatrix(matrix);
+    applyZoom();
 }
 
 void NetworkView::mousePressEvent(QMouseEvent *event)
 {
+    // Start a rectangle (Ctrl) or lasso (Ctrl+Shift) selection instead of panning or clicking an element
+    if (event->button() == Qt::LeftButton && (event->modifiers() & Qt::ControlModifier) && scene())
+    {
+        selecting = ((event->modifiers() & Qt::ShiftModifier) ? LassoSelection : RectSelection);
+        selectionStart = mapToScene(event->pos());
+        selectionPolygon = QPolygonF() << selectionStart;
+        return;
+    }
+
     // Store click position
     lastClick = event->pos();
     
-    // Generate the list of graphics items under the mouse click
-    itemList = items(lastClick);
+    // Generate the list of graphics items under the mouse click; the exact test is left to
+    // generateClickedIndexList
+    itemList = itemsNear(mapToScene(lastClick), pickPixels);
     
-    // Workaround: the function generateClickedIndexList accesses the selected bool value of PointElements and
-    // PathElements. This bool value gets set in the slot Model::SelectionChanged which is triggered when the 
-    // mousePressEvent is further processed.
-    // Change: Use a slot in the NetworkView too that is called and creates the ClickedIndices list
-    // Can the status bar still be updated with the number of selected items?
-    // Process event
+    // The element on top of the stack takes the press, and starts a drag if it is the selected one;
+    // the elements do not select themselves, so that a click changes the selection only once, here
     QGraphicsView::mousePressEvent(event);
 
     generateClickedIndexList();
     itemsLastClick = clickedIndices.size();
 
+    // Select the best ranked element, unless the click started dragging the selected element
+    if (event->button() == Qt::LeftButton && currentIndex != 0 && !clickedIndices.isEmpty())
+    {
+        Item *current = (currentIndex >= 0 ? clickedIndices[currentIndex] : 0);
+        bool dragging = current && ((current->hasPath && current->graphicItem1->isMoving()) ||
+                                    (current->hasPoint && current->graphicItem2->isMoving()));
+        if (!dragging) selectClicked(0);
+    }
+
     // Emit a message for the status bar with the mouse coordinates and the items under it
     QPointF currentPos = mapToScene(event->pos());
     QString message = tr("Position: ") + QString::number(currentPos.x(), 'f', 2) + ", " + QString::number(currentPos.y(), 'f', 2);
@@ -106,16 +360,97 @@ void NetworkView::mousePressEvent(QMouseEvent *event)
 
 void NetworkView::mouseMoveEvent(QMouseEvent *event)
 {
-    // Emit a message for the status bar with the mouse coordinates
+    // Schedule a message for the status bar with the mouse coordinates and the element under them
     QPointF currentPos = mapToScene(event->pos());
-    QString message = tr("Position: ") + QString::number(currentPos.x(), 'f', 2) + ", " + QString::number(currentPos.y(), 'f', 2);
-    if (itemsLastClick > 1) message += "         " + QString::number(itemsLastClick) + tr(" items @ last click  (toggle with spacebar)");
-    emit updateStatusBar(message);
+    hoverPos = event->pos();
+    hoverButtons = (event->buttons() != Qt::NoButton);
+    if (!hoverTimer.isActive()) hoverTimer.start();
+
+    // Extend the selection outline
+    if (selecting != NoSelection)
+    {
+        if (selecting == RectSelection)
+            selectionPolygon = QPolygonF(QRectF(selectionStart, currentPos).normalized());
+        else if (QLineF(mapFromScene(selectionPolygon.last()), event->pos()).length() >= lassoStep)
+            selectionPolygon << currentPos;
+        viewport()->update();
+        return;
+    }
 
     // Process event
     QGraphicsView::mouseMoveEvent(event);
 }
 
+void NetworkView::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (selecting != NoSelection && event->button() == Qt::LeftButton)
+    {
+        finishSelection();
+        return;
+    }
+    QGraphicsView::mouseReleaseEvent(event);
+}
+
+void NetworkView::finishSelection()
+{
+    SelectionShape shape = selecting;
+    QPolygonF area = selectionPolygon;
+    selecting = NoSelection;
+    selectionPolygon.clear();
+    viewport()->update();
+    if (area.count() < 3) return;
+
+    // The scene index returns the elements whose bounding rectangle crosses the one of the outline.
+    // With a rectangle, the elements inside it are taken as they are and only the ones on its border
+    // are tested against their shape; with a lasso, only those with a vertex inside it are kept
+    QRectF bounds = area.boundingRect();
+    QPainterPath boundsPath;
+    boundsPath.addRect(bounds);
+    QList<QGraphicsItem *> candidates = scene()->items(bounds, Qt::IntersectsItemBoundingRect);
+    QSet<Item*> found;
+    QList<Item*> selected;
+    for (int i = 0; i < candidates.count(); ++i)
+    {
+        QGraphicsItem *candidate = candidates[i];
+        PathElement *pathit;
+        PointElement *pointit;
+        if (!candidate->isVisible() || !elementOf(candidate, pathit, pointit)) continue;
+        if (shape == RectSelection && !bounds.contains(candidate->sceneBoundingRect())
+                && !candidate->collidesWithPath(candidate->mapFromScene(boundsPath), Qt::IntersectsItemShape))
+            continue;
+
+        Item *item;
+        QVector<QPointF> vertices;
+        if (pathit)
+        {
+            item = pathit->getItem();
+            if (shape == LassoSelection) vertices = pathit->snapPoints();
+        }
+        else
+        {
+            item = pointit->getItem();
+            if (shape == LassoSelection) vertices = pointit->snapPoints();
+        }
+
+        if (shape == LassoSelection)
+        {
+            bool inside = false;
+            for (int j = 0; !inside && j < vertices.count(); ++j)
+                inside = area.containsPoint(vertices[j], Qt::OddEvenFill);
+            if (!inside) continue;
+        }
+
+        // Plain junctions have a path and a point element
+        if (!found.contains(item))
+        {
+            found.insert(item);
+            selected.append(item);
+        }
+    }
+
+    emit elementsSelected(selected);
+}
+
 void NetworkView::keyPressEvent(QKeyEvent *event)
 {
     // Page Up zooms in
@@ -123,10 +458,7 @@ void NetworkView::keyPressEvent(QKeyEvent *event)
     {
         setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
         zoom += 0.5;
-        qreal scale = qExp(zoom);
-        QMatrix matrix;
-        matrix.scale(scale, -scale);
-        setMatrix(matrix);
+        applyZoom();
     }
 
     // Page Down zooms out
@@ -134,28 +466,14 @@ void NetworkView::keyPressEvent(QKeyEvent *event)
     {
         setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
         zoom -= 0.5;
-        qreal scale = qExp(zoom);
-        QMatrix matrix;
-        matrix.scale(scale, -scale);
-        setMatrix(matrix);
+        applyZoom();
     }
 
     // The space bar toggles the selection among all items at the point of the last click
     if (event->key() == Qt::Key_Space)
     {
-        if ( !clickedIndices.isEmpty() ) {
-            ++currentIndex;
-            if (currentIndex >= clickedIndices.size()) currentIndex = 0;
-            //selectionModel->select(clickedIndices[currentIndex], QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows);
-            
-            if (clickedIndices[currentIndex]->hasPath) {
-                selectionModel->select( clickedIndices[currentIndex]->graphicItem1->model->index(clickedIndices[currentIndex]), 
-                    QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows);
-            } else if (clickedIndices[currentIndex]->hasPoint) {
-                selectionModel->select( clickedIndices[currentIndex]->graphicItem2->model->index(clickedIndices[currentIndex]), 
-                   QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows);
-            }
-        }
+        if ( !clickedIndices.isEmpty() )
+            selectClicked(currentIndex + 1 < clickedIndices.size() ? currentIndex + 1 : 0);
     }
 
     // The del key should delete the selected item
@@ -166,7 +484,7 @@ void NetworkView::keyPressEvent(QKeyEvent *event)
     if (event->key() == Qt::Key_Delete)
     {
         // only process event, if at least one object is selected
-        if (clickedIndices.size() > 0)
+        if (currentIndex >= 0 && currentIndex < clickedIndices.size())
         {
             QMessageBox::information(NULL, "NetworkView", "Received Delete Event");
             //Item *item = static_cast<Item*>(clickedIndices[currentIndex].internalPointer());
@@ -189,52 +507,158 @@ void NetworkView::keyPressEvent(QKeyEvent *event)
     }
 }
 
-void NetworkView::generateClickedIndexList()
+void NetworkView::updateHover()
+{
+    QPointF point = mapToScene(hoverPos);
+    QString message = tr("Position: ") + QString::number(point.x(), 'f', 2) + ", " + QString::number(point.y(), 'f', 2);
+
+    // The scene index returns the elements near the cursor, and the nearest one within the
+    // tolerance is reported; nothing is looked up while dragging
+    if (!hoverButtons && scene())
+    {
+        static const char *typeNames[] = { QT_TR_NOOP("Edge"), QT_TR_NOOP("Lane"), QT_TR_NOOP("Junction"), QT_TR_NOOP("Connection"),
+                                           QT_TR_NOOP("tlLogic"), QT_TR_NOOP("Request"), QT_TR_NOOP("Phase") };
+        qreal tolerance = qMin(hoverPixels / qExp(zoom), qreal(maxPickRadius));
+        QList<QGraphicsItem *> nearby = itemsNear(point, hoverPixels);
+        ClickCandidate nearest, candidate;
+        nearest.item = 0;
+        for (int i = 0; i < nearby.count(); ++i)
+            if (nearby[i]->isVisible() && candidateOf(nearby[i], point, candidate) && candidate.distance <= tolerance)
+                if (!nearest.item || candidate.distance < nearest.distance)
+                    nearest = candidate;
+        if (nearest.item)
+            message += "         " + tr(typeNames[nearest.item->type]) + " " + nearest.item->name;
+    }
+
+    if (itemsLastClick > 1) message += "         " + QString::number(itemsLastClick) + tr(" items @ last click  (toggle with spacebar)");
+    emit updateStatusBar(message);
+}
+
+QList<QGraphicsItem *> NetworkView::itemsNear(const QPointF &point, int pixels) const
 {
+    // The item bounds only cover the pen, so the scene index is queried over a square widened by
+    // the distance, which depends on the zoom; at low zoom it is capped, like the snap search
+    if (!scene()) return QList<QGraphicsItem *>();
+    qreal radius = qMin(pixels / qExp(zoom), qreal(maxPickRadius));
+    return scene()->items(QRectF(point.x() - radius, point.y() - radius, 2 * radius, 2 * radius), Qt::IntersectsItemBoundingRect);
+}
+
+bool NetworkView::candidateOf(QGraphicsItem *element, const QPointF &point, ClickCandidate &candidate) const
+{
+    // Rank of each kind of Path Element; Point Elements come first
+    static const int pathPriority[] = { 3, 3, 2, 2, 5, 4, 1 };
+
     PathElement *pathit;
     PointElement *pointit;
-    bool repeated;
+    if (!elementOf(element, pathit, pointit)) return false;
+    if (pathit)
+    {
+        candidate.item = pathit->getItem();
+        candidate.priority = pathPriority[pathit->type];
+        candidate.distance = pathit->distanceTo(pathit->mapFromScene(point));
+        return true;
+    }
+    candidate.item = pointit->getItem();
+    candidate.priority = 0;
+    candidate.distance = QLineF(pointit->mapFromScene(point), pointit->rect().center()).length();
+    return true;
+}
 
-    // Generate a list of pointers to the selected model items at the last click avoiding repetitions
-    // Repetition can be caused by plain junctions with a path element and a point element
-    clickedIndices.clear();
+void NetworkView::generateClickedIndexList()
+{
+    // Repetition can be caused by plain junctions with a path element and a point element; a hash
+    // keeps the best ranked element of each model item
+    QPointF point = mapToScene(lastClick);
+    QVector<ClickCandidate> candidates;
+    QHash<Item*, int> positions;
+    Item *selectedItem = 0;
     for (int i = 0; i < itemList.count(); ++i)
     {
-        pathit = dynamic_cast <PathElement*>(itemList[i]);
-        if (pathit != NULL)
-        {
-            repeated = false;
-            for (int j = 0; j < clickedIndices.size(); ++j)
-                if (pathit->getItem() == clickedIndices[j])
-                    repeated = true;
-            if (!repeated)
-            {
-                clickedIndices.append(pathit->getItem());
-                if (pathit->isSelected()) currentIndex = i;
-            }
-        }
-        else
+        // Path Elements are hit within the pick tolerance of their center line, Point Elements inside their circle
+        ClickCandidate candidate;
+        if (!itemList[i]->isVisible() || !itemList[i]->contains(itemList[i]->mapFromScene(point))) continue;
+        if (!candidateOf(itemList[i], point, candidate)) continue;
+
+        // Path Elements and Point Elements keep the selection of their item
+        if ((candidate.item->hasPath && candidate.item->graphicItem1->isSelected()) ||
+            (candidate.item->hasPoint && candidate.item->graphicItem2->isSelected()))
+            selectedItem = candidate.item;
+        QHash<Item*, int>::const_iterator position = positions.constFind(candidate.item);
+        if (position == positions.constEnd())
         {
-            pointit = dynamic_cast <PointElement*>(itemList[i]);
-            if (pointit != NULL)
-            {
-                repeated = false;
-                for (int j = 0; j < clickedIndices.size(); ++j)
-                    if (pointit->getItem() == clickedIndices[j])
-                        repeated = true;
-                if (!repeated)
-                {
-                    clickedIndices.append(pointit->getItem());
-                    if (pointit->isSelected()) currentIndex = i;
-                }
-            }
+            positions.insert(candidate.item, candidates.count());
+            candidates.append(candidate);
         }
+        else if (candidate < candidates[position.value()])
+            candidates[position.value()] = candidate;
+    }
+    qStableSort(candidates);
+
+    // The current index points into the deduplicated list, at the item the click selected
+    clickedIndices.clear();
+    currentIndex = -1;
+    for (int i = 0; i < candidates.count(); ++i)
+    {
+        clickedIndices.append(candidates[i].item);
+        if (candidates[i].item == selectedItem) currentIndex = i;
     }
     
     qDebug() << "NetworkView::generateClickedIndexList: itemList.count=" << QString::number(itemList.count()) 
       << ", currentIndex=" << QString::number(currentIndex);
 }
 
+void NetworkView::selectClicked(int index)
+{
+    currentIndex = index;
+    Item *item = clickedIndices[index];
+    if (item->hasPath) {
+        selectionModel->select(item->graphicItem1->model->index(item),
+            QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows);
+    } else if (item->hasPoint) {
+        selectionModel->select(item->graphicItem2->model->index(item),
+            QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows);
+    }
+}
+
+void NetworkView::applyZoom()
+{
+    qreal scale = qExp(zoom);
+
+    // Adjust matrix accordingly; yScale is multiplied by -1 given
+    // the Graphics View coordinates are in the opposite direction
+    QMatrix matrix;
+    matrix.scale(scale, -scale);
+    beginInteraction();
+    setMatrix(matrix);
+    updatePickTolerance(scale);
+    emit visibleAreaChanged(visibleArea());
+}
+
+QRectF NetworkView::visibleArea() const
+{
+    return mapToScene(viewport()->rect()).boundingRect();
+}
+
+void NetworkView::scrollContentsBy(int dx, int dy)
+{
+    beginInteraction();
+    QGraphicsView::scrollContentsBy(dx, dy);
+    emit visibleAreaChanged(visibleArea());
+}
+
+void NetworkView::resizeEvent(QResizeEvent *event)
+{
+    QGraphicsView::resizeEvent(event);
+    emit visibleAreaChanged(visibleArea());
+}
+
+void NetworkView::updatePickTolerance(qreal scale)
+{
+    // Path elements are picked within a few pixels of their center line, whatever the zoom
+    PathElement::setPickTolerance(pickPixels / scale);
+    SnapIndex::setTolerance(snapPixels / scale);
+}
+
 void NetworkView::setSelectionModel(QItemSelectionModel *selectionModel)
 {
     // Selection model setter
@@ -23,9 +23,14 @@
 #define NETWORKVIEW_H
 
 #include "item.h"
+#include "statsoverlay.h"
+#include "animator.h"
+#include "labellayer.h"
 #include <QGraphicsView>
+#include <QTimer>
 #include <QPoint>
 #include <QItemSelectionModel>
+#include <QPolygonF>
 
 class NetworkView : public QGraphicsView
 {
@@ -40,21 +45,92 @@ public:
     // Sets item selection model
     void setSelectionModel(QItemSelectionModel *selectionModel);
 
+    // Part of the scene shown in the viewport
+    QRectF visibleArea() const;
+
+    // Animator driving the highlights of the elements shown in the view
+    Animator *animator() const;
+
+    // Id labels drawn over the network
+    LabelLayer *labelLayer() const;
+
+    // Starts and stops logging the rendering statistics into a CSV file
+    bool startStatsLog(const QString &fileName);
+    void stopStatsLog();
+
+public slots:
+    // Shows or hides the rendering statistics overlay
+    void showStats(bool show);
+
+    // Redraws a region of the cached background (in scene coordinates); a null rect redraws all of it
+    void invalidateBackground(QRectF rect);
+
+private slots:
+    // Starts the full quality pass once the input is idle, and paints the next strip of it
+    void startRefine();
+    void refineStep();
+
+    // Reports the position of the cursor and the nearest element; called once per frame at most
+    void updateHover();
+
 signals:
     // Generates a message with the current mouse coordinates and number of items in last click
     void updateStatusBar(QString message);
 
+    // Emitted when the view is scrolled, zoomed or resized
+    void visibleAreaChanged(QRectF area);
+
+    // Emitted with the items of the visible elements inside a selection rectangle or lasso
+    void elementsSelected(QList<Item*> items);
+
 protected:
     // Mouse and keyboard events
     void wheelEvent(QWheelEvent *event);
     void mousePressEvent(QMouseEvent *event);
     void mouseMoveEvent(QMouseEvent *event);
+    void mouseReleaseEvent(QMouseEvent *event);
     void keyPressEvent(QKeyEvent *event);
 
+    // Times every frame when the rendering statistics are on
+    void paintEvent(QPaintEvent *event);
+
+    // Draws the static network into the background, which the view caches
+    void drawBackground(QPainter *painter, const QRectF &rect);
+
+    // Draws the id labels and the selection rectangle or lasso over the elements
+    void drawForeground(QPainter *painter, const QRectF &rect);
+
+    // Report the visible area after scrolling and resizing
+    void scrollContentsBy(int dx, int dy);
+    void resizeEvent(QResizeEvent *event);
+
 private:
     // Zoom
     qreal zoom;
 
+    // Distance in pixels within which a click picks a path element
+    static const int pickPixels = 4;
+
+    // Distance in pixels within which a dragged node snaps to another element
+    static const int snapPixels = 8;
+
+    // Converts the pick and snap distances into scene units for the current scale
+    void updatePickTolerance(qreal scale);
+
+    // Sets the view matrix for the current zoom value
+    void applyZoom();
+
+    // While panning and zooming, the background is drawn without antialiasing and in low detail
+    // within a time budget; when the input is idle for a moment, it is drawn again in full quality
+    // strip by strip, which stops as soon as the user pans or zooms again
+    bool interacting;
+    QTimer idleTimer, refineTimer;
+    int refineStrip;
+    static const int frameBudget = 25;
+    static const int idleDelay = 250;
+    static const int stripHeight = 64;
+    void beginInteraction();
+
     // Pointer to the item selection model
     QItemSelectionModel *selectionModel;
 
@@ -68,11 +144,83 @@ private:
     //QVector <QModelIndex> clickedIndices;
     QList<Item*> clickedIndices;
 
-    // Generates 'clickIndices' from 'itemList'
+    // Generates 'clickIndices' from 'itemList': each model item once, the small elements (points
+    // and connections) before lanes, edges and junction polygons, and the nearest first within each kind;
+    // elements with the same rank and distance keep the stacking order
     void generateClickedIndexList();
 
+    // Selects the item at 'index' in 'clickedIndices' and makes it the current one
+    void selectClicked(int index);
+
+    // Model item under the last click with its rank
+    struct ClickCandidate
+    {
+        Item *item;
+        int priority;
+        qreal distance;
+        bool operator<(const ClickCandidate &other) const
+        {
+            return (priority != other.priority ? priority < other.priority : distance < other.distance);
+        }
+    };
+
+    // Graphic items whose bounding rectangle lies within a distance in pixels of a scene point,
+    // from the scene index; the distance is capped at maxPickRadius in scene units
+    QList<QGraphicsItem *> itemsNear(const QPointF &point, int pixels) const;
+    static const int maxPickRadius = 200;
+
+    // Fills in the model item, rank and distance to a scene point of a Path Element or Point
+    // Element; returns false for other graphic items
+    bool candidateOf(QGraphicsItem *element, const QPointF &point, ClickCandidate &candidate) const;
+
+    // Mouse moves only record the cursor position; the status bar is updated when the timer
+    // fires, so that high rate mice do not flood the event loop
+    QPoint hoverPos;
+    bool hoverButtons;
+    QTimer hoverTimer;
+    static const int hoverInterval = 16;
+
+    // Distance in pixels within which the element under the cursor is reported
+    static const int hoverPixels = 6;
+
     // Items in the last click and current index of them
     int itemsLastClick, currentIndex;
+
+    // Ctrl+drag selects the elements crossing a rectangle, and Ctrl+Shift+drag the elements
+    // with a vertex inside a lasso; the outline is kept in scene coordinates
+    enum SelectionShape { NoSelection, RectSelection, LassoSelection };
+    SelectionShape selecting;
+    QPointF selectionStart;
+    QPolygonF selectionPolygon;
+
+    // Minimum distance in pixels between the points of a lasso
+    static const int lassoStep = 4;
+
+    // Queries the scene index for the elements in the selection outline and emits elementsSelected()
+    void finishSelection();
+
+    // Rendering statistics overlay
+    StatsOverlay *statsOverlay;
+
+    // Animation scheduler shared by all the elements
+    Animator *elementAnimator;
+
+    // Id labels
+    LabelLayer *labels;
+
+    // Number of visible items in the scene per category; counted again in the next frame after
+    // the model reports a geometry change, since edits add, remove and hide elements
+    int itemTotals[PaintStats::CategoryCount];
+    bool itemTotalsValid;
+    void countItems();
+
+    // Time spent in the scene index queries of drawBackground() during the current frame, and
+    // the number of items they returned; zero when the cached background is reused
+    qint64 frameIndexNs;
+    int frameCandidates;
+
+    // Switches paint counting on or off depending on whether the statistics are shown or logged
+    void updateStatsEnabled();
 };
 
 #endif // NETWORKVIEW_H
@@ -0,0 +1,153 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#include "netwriter.h"
+
+#include <QDomDocument>
+#include <QIODevice>
+#include <QXmlStreamWriter>
+#include <QVector>
+#include <QPair>
+#include <QtAlgorithms>
+
+// Attribute order of the elements written by netconvert: each tag with its attribute names,
+// separated by spaces, so that a tag may list any number of them
+static const char *const attributeOrder[][2] = {
+    { "net", "version junctionCornerDetail junctionLinkDetail walkingareas limitTurnSpeed "
+             "xmlns:xsi xsi:noNamespaceSchemaLocation" },
+    { "location", "netOffset convBoundary origBoundary projParameter" },
+    { "type", "id priority numLanes speed allow disallow oneway width" },
+    { "edge", "id from to name priority type function spreadType shape crossingEdges distance bidi" },
+    { "lane", "id index allow disallow speed length width endOffset acceleration customShape shape" },
+    { "tlLogic", "id type programID offset" },
+    { "phase", "duration state minDur maxDur name next" },
+    { "junction", "id type x y z incLanes intLanes shape radius customShape rightOfWay fringe name" },
+    { "request", "index response foes cont" },
+    { "connection", "from to fromLane toLane pass via tl linkIndex dir state" },
+    { "roundabout", "nodes edges" },
+    { "param", "key value" },
+    { 0, 0 }
+};
+
+NetWriter::NetWriter()
+{
+    for (int i = 0; attributeOrder[i][0]; ++i)
+    {
+        QStringList names = QString(attributeOrder[i][1]).split(' ', QString::SkipEmptyParts);
+        QHash<QString, int> &rank = attributeRank[attributeOrder[i][0]];
+        for (int j = 0; j < names.count(); ++j)
+            rank.insert(names[j], j + 1);
+    }
+}
+
+bool NetWriter::write(const QDomDocument &document, QIODevice *device, QString *errorMessage)
+{
+    QXmlStreamWriter writer(device);
+    writer.setAutoFormatting(true);
+    writer.setAutoFormattingIndent(indent);
+
+    writer.writeStartDocument();
+    for (QDomNode node = document.firstChild(); !node.isNull(); node = node.nextSibling())
+    {
+        // The XML declaration has already been written by writeStartDocument()
+        if (node.isProcessingInstruction() && node.nodeName() == "xml")
+            continue;
+        writeNode(writer, node);
+    }
+    writer.writeEndDocument();
+
+    if (writer.hasError())
+    {
+        if (errorMessage)
+            *errorMessage = device->errorString();
+        return false;
+    }
+    return true;
+}
+
+void NetWriter::writeElement(QXmlStreamWriter &writer, const QDomElement &element)
+{
+    if (element.hasChildNodes())
+    {
+        writer.writeStartElement(element.tagName());
+        writeAttributes(writer, element);
+        // Walk siblings directly: childNodes() would build a list of every child first
+        for (QDomNode child = element.firstChild(); !child.isNull(); child = child.nextSibling())
+            writeNode(writer, child);
+        writer.writeEndElement();
+    }
+    else
+    {
+        writer.writeEmptyElement(element.tagName());
+        writeAttributes(writer, element);
+    }
+}
+
+void NetWriter::writeNode(QXmlStreamWriter &writer, const QDomNode &node)
+{
+    switch (node.nodeType())
+    {
+    case QDomNode::ElementNode:
+        writeElement(writer, node.toElement());
+        break;
+    case QDomNode::CommentNode:
+        writer.writeComment(node.toComment().data());
+        break;
+    case QDomNode::CDATASectionNode:
+        writer.writeCDATA(node.toCDATASection().data());
+        break;
+    case QDomNode::TextNode:
+        // Whitespace only text is the indentation of the source file, which the auto-formatting
+        // writes anew; SUMO networks have no mixed content, so no other whitespace is meaningful
+        if (!node.toText().data().trimmed().isEmpty())
+            writer.writeCharacters(node.toText().data());
+        break;
+    case QDomNode::ProcessingInstructionNode:
+        writer.writeProcessingInstruction(node.toProcessingInstruction().target(),
+                                          node.toProcessingInstruction().data());
+        break;
+    default:
+        break;
+    }
+}
+
+void NetWriter::writeAttributes(QXmlStreamWriter &writer, const QDomElement &element)
+{
+    QDomNamedNodeMap attributes = element.attributes();
+    int count = attributes.count();
+    if (count == 0)
+        return;
+
+    // QDomNamedNodeMap is a hash, so its order changes from run to run; sort the names by
+    // their rank for this tag and then alphabetically
+    const QHash<QString, int> rank = attributeRank.value(element.tagName());
+    QVector<QPair<int, QString> > names;
+    names.reserve(count);
+    for (int i = 0; i < count; ++i)
+    {
+        QString name = attributes.item(i).nodeName();
+        names.append(qMakePair(rank.value(name, rank.size() + 1), name));
+    }
+    qSort(names);
+
+    for (int i = 0; i < count; ++i)
+        writer.writeAttribute(names.at(i).second, element.attribute(names.at(i).second));
+}
@@ -0,0 +1,64 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#ifndef NETWRITER_H
+#define NETWRITER_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+
+QT_BEGIN_NAMESPACE
+class QDomDocument;
+class QDomNode;
+class QDomElement;
+class QIODevice;
+class QXmlStreamWriter;
+QT_END_NAMESPACE
+
+class NetWriter
+{
+public:
+    NetWriter();
+
+    // Streams the document into 'device' node by node, in document order, without building
+    // the whole text in memory first. Attributes are written in the order SUMO itself uses
+    // for each tag, followed by any others sorted by name, so that saving an unchanged
+    // network twice gives byte-identical files. Whitespace only text is not copied: the
+    // indentation is written by the auto-formatting instead
+    // Returns false and fills in 'errorMessage' if the device could not be written
+    bool write(const QDomDocument &document, QIODevice *device, QString *errorMessage = 0);
+
+    // Writes a single element and its subtree; the writer must already be positioned
+    void writeElement(QXmlStreamWriter &writer, const QDomElement &element);
+
+    // Indentation used by the auto-formatting, matching the files written by SUMO
+    static const int indent = 4;
+
+private:
+    void writeNode(QXmlStreamWriter &writer, const QDomNode &node);
+    void writeAttributes(QXmlStreamWriter &writer, const QDomElement &element);
+
+    // Rank of each attribute name within its tag; attributes not listed rank after all of them
+    QHash<QString, QHash<QString, int> > attributeRank;
+};
+
+#endif // NETWRITER_H
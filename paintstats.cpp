@@ -0,0 +1,54 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#include "paintstats.h"
+
+bool PaintStats::enabled = false;
+int PaintStats::paintCalls[PaintStats::PassCount][PaintStats::CategoryCount];
+
+void PaintStats::reset()
+{
+    for (int pass = 0; pass < PassCount; ++pass)
+        for (int i = 0; i < CategoryCount; ++i)
+            paintCalls[pass][i] = 0;
+}
+
+int PaintStats::total(Pass pass)
+{
+    int calls = 0;
+    for (int i = 0; i < CategoryCount; ++i)
+        calls += paintCalls[pass][i];
+    return calls;
+}
+
+const char *PaintStats::name(int category)
+{
+    switch (category)
+    {
+        case Edges:         return "edges";
+        case Lanes:         return "lanes";
+        case IntLanes:      return "int_lanes";
+        case Junctions:     return "junctions";
+        case IntJunctions:  return "int_junctions";
+        case Connections:   return "connections";
+        default:            return "";
+    }
+}
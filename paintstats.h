@@ -0,0 +1,54 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#ifndef PAINTSTATS_H
+#define PAINTSTATS_H
+
+class PaintStats
+{
+public:
+    // Element categories, following the layers of the Controls view
+    enum Category { Edges, Lanes, IntLanes, Junctions, IntJunctions, Connections, CategoryCount };
+
+    // The static elements are painted into the cached background of the view, and the selected,
+    // highlighted and dragged ones over it in the item pass
+    enum Pass { BackgroundPass, ItemPass, PassCount };
+
+    // Counting is only done while the rendering statistics are shown or logged
+    static bool enabled;
+
+    // Number of paint() calls per pass and category in the current frame
+    static int paintCalls[PassCount][CategoryCount];
+
+    // Counts a call to paint(); called by the Path and Point Elements
+    static void count(Category category, Pass pass) { if (enabled) ++paintCalls[pass][category]; }
+
+    // Clears the counters at the start of a frame
+    static void reset();
+
+    // Total number of paint() calls of a pass in the current frame
+    static int total(Pass pass);
+
+    // Short caption of a category
+    static const char *name(int category);
+};
+
+#endif // PAINTSTATS_H
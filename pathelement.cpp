@@ -21,6 +21,7 @@
 
 #include "pathelement.h"
 #include "item.h"
+#include "snapindex.h"
 
 #include <QPen>
 #include <QBrush>
@@ -28,6 +29,7 @@
 #include <QGraphicsScene>
 #include <QGraphicsSceneMouseEvent>
 #include <QPointF>
+#include <QLineF>
 #include <qmath.h>
 #include <QCursor>
 #include <QMenu>
@@ -36,6 +38,9 @@
 #include <QApplication>
 #include <QDebug>
 
+qreal PathElement::pickTolerance = 0.7;
+bool PathElement::lowDetail = false;
+
 PathElement::PathElement(ElementType type, QString shape, Model *model, Item *item, QItemSelectionModel *selectionModel)
 {
     // Initialise members
@@ -71,14 +76,22 @@ PathElement::PathElement(ElementType type, QString shape, Model *model, Item *it
     editable = false;
     showArrow = false;
     gripRadius = 0.6;
-    blink = -1;
+    blinkOn = false;
     blinkingNode = -1;
+    colourOverride = 0;
+    snapped = false;
+    following = false;
     selectedNode = -1;
+    arrowValid = false;
+    boundsValid = false;
+    segmentsValid = false;
 
     // Calculate paths and create QGraphicsPathItem
     calcPaths();
     QGraphicsPathItem(centerPath);
 
+    committedBounds = boundingRect();
+
     // Set arrow cursor
     setCursor(QCursor(Qt::ArrowCursor));
 
@@ -87,17 +100,17 @@ PathElement::PathElement(ElementType type, QString shape, Model *model, Item *it
 
 void PathElement::select()
 {
-    // Set selected as true, bring element to front and redraw
+    // Set selected as true and redraw; the element is painted over the cached background,
+    // so the elements underneath are not repainted
     selected = true;
-    setZValue(10);
     update();
 }
 
 void PathElement::deselect()
 {
-    // Set selected as false, put element back into its normal position and redraw
+    // Set selected as false and redraw; the background pass of paint() holds every element
+    // in its normal style
     selected = false;
-    setZValue(z);
     update();
 }
 
@@ -106,9 +119,93 @@ bool PathElement::isSelected() const
     return selected;
 }
 
+bool PathElement::isDynamic() const
+{
+    return selected || blinkOn || blinkingNode >= 0 || selectedNode > -1 || following;
+}
+
+bool PathElement::isMoving() const
+{
+    return selectedNode > -1 || following;
+}
+
+void PathElement::follow(const QPointF &delta, FollowPart part)
+{
+    if (nodes.isEmpty()) return;
+
+    // Take the element out of the background on the first move
+    if (!following)
+    {
+        following = true;
+        invalidateBackground();
+    }
+
+    prepareGeometryChange();
+    switch (part)
+    {
+    case WholePath:
+        for (int i = 0; i < nodes.count(); ++i)
+            nodes[i] += delta;
+        break;
+    case FirstNode:
+        nodes.first() += delta; break;
+    case LastNode:
+        nodes.last() += delta; break;
+    }
+    calcPaths();
+    update();
+}
+
+void PathElement::followShape(const QList<QPointF> &nodes)
+{
+    if (nodes.isEmpty()) return;
+
+    // Take the element out of the background on the first change
+    if (!following)
+    {
+        following = true;
+        invalidateBackground();
+    }
+
+    prepareGeometryChange();
+    this->nodes = nodes;
+    calcPaths();
+    update();
+}
+
+void PathElement::endFollow()
+{
+    if (!following) return;
+    following = false;
+
+    // Connections and edges without a shape are drawn from other elements and have no shape to write
+    if (type == Connection || type == EdgeNoShape)
+        commitGeometry();
+    else
+        updateXML();
+    update();
+}
+
+void PathElement::setNodes(const QList<QPointF> &nodes)
+{
+    if (nodes.isEmpty()) return;
+    prepareGeometryChange();
+    this->nodes = nodes;
+    calcPaths();
+    committedBounds = boundingRect();
+    model->snapIndex()->setPoints(this, snapPoints());
+}
+
+void PathElement::invalidateBackground()
+{
+    if (scene())
+        scene()->invalidate(sceneBoundingRect(), QGraphicsScene::BackgroundLayer);
+}
+
 void PathElement::switchState(Model::ElementProperty prop, bool state)
 {
-    // Change element property
+    // Change element property; the cached background is refreshed by the caller once for
+    // all the elements switched, only the elements painted over it are updated here
     switch (prop)
     {
     case Model::ViewElement:
@@ -119,20 +216,21 @@ void PathElement::switchState(Model::ElementProperty prop, bool state)
         if (selected) update();
         break;
     case Model::WireElement:
+        // Only the pen width changes; the bounds and the hit test data do not depend on it
         isWired = state;
-        calcPaths();
-        if (selected) select(); else deselect();
+        if (isDynamic()) update();
         break;
     case Model::ArrowElement:
         showArrow = state;
-        update();
+        if (isDynamic()) update();
         break;
     }
 }
 
 void PathElement::mousePressEvent(QGraphicsSceneMouseEvent *event)
 {
-    // Select a node if within the gripRadius of one
+    // Select a node if within the gripRadius of one; the network view selects the element ranked
+    // first under the click
     selectedNode = -1;
     if (selected && editable)
     {
@@ -145,12 +243,12 @@ void PathElement::mousePressEvent(QGraphicsSceneMouseEvent *event)
             }
         }
         lastPos = event->pos();
+        if (selectedNode > -1) dragPos = nodes[selectedNode];
+
+        // Take the element out of the background while its node is dragged
+        if (selectedNode > -1) invalidateBackground();
         update();
     }
-
-    // Select the element in the tree and trigger all the selection processes
-    if (selectionModel)
-        selectionModel->select(modelIndex, QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows);
 }
 
 void PathElement::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
@@ -158,14 +256,82 @@ void PathElement::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
     // Move the node if previously clicked on one, and update the geometry
     if (selectedNode > -1)
     {
-        nodes[selectedNode] += event->pos() - lastPos;
+        dragPos += event->pos() - lastPos;
         lastPos = event->pos();
 
-        // Update center and border paths
+        // Snap to the nearest vertex of another element unless Alt is held
+        QPointF target;
+        snapped = !(event->modifiers() & Qt::AltModifier) && model->snapIndex()->nearest(dragPos, this, target);
+        moveNode(selectedNode, (snapped ? target : dragPos));
+
+        // Moving the end of a lane reshapes the turns of its junction
+        if (type == NormalLane && (selectedNode == 0 || selectedNode == nodes.count() - 1))
+            model->laneEndMoved(this, selectedNode == 0, false);
+    }
+}
+
+void PathElement::moveNode(int i, const QPointF &pos)
+{
+    // Area of the adjacent segments before the move
+    QRectF dirty = nodeBounds(i);
+    nodes[i] = pos;
+
+    // Move the node in the center path; the closing element of a junction polygon repeats the first node
+    centerPath.setElementPositionAt(i, pos.x(), pos.y());
+    if (i == 0 && centerPath.elementCount() > nodes.count())
+        centerPath.setElementPositionAt(nodes.count(), pos.x(), pos.y());
+
+    // Only the bounding boxes of the two segments at the node change
+    if (segmentsValid)
+    {
+        int segments = segmentBounds.count();
+        int before = (type == PlainJunction ? (i + segments - 1) % segments : i - 1);
+        if (before >= 0)
+            segmentBounds[before] = QRectF(nodes[before], nodes[(before + 1) % nodes.count()]).normalized();
+        if (i < segments)
+            segmentBounds[i] = QRectF(nodes[i], nodes[(i + 1) % nodes.count()]).normalized();
+    }
+
+    // The bounds only grow during the drag, with some slack, so that the element is rarely
+    // reinserted into the scene index; the exact bounds are restored by endDrag()
+    if (!boundsValid) boundingRect();
+    qreal margin = boundsMargin();
+    QRectF node(pos.x() - margin, pos.y() - margin, 2 * margin, 2 * margin);
+    if (!bounds.contains(node))
+    {
+        qreal slack = qMax(qreal(dragSlack), qMax(bounds.width(), bounds.height()) / 4);
         prepareGeometryChange();
-        calcPaths();
-        update();
+        bounds = bounds.united(node).adjusted(-slack, -slack, slack, slack);
     }
+
+    // The direction arrow is left where it was until the end of the drag
+    update(dirty.united(nodeBounds(i)));
+}
+
+void PathElement::endDrag()
+{
+    // Rebuild the path and the exact bounds once
+    prepareGeometryChange();
+    calcPaths();
+    update();
+}
+
+QRectF PathElement::nodeBounds(int i) const
+{
+    // Segments at the node, widened by the pen and the node markers
+    QRectF area(nodes[i], nodes[i]);
+    if (i > 0 || type == PlainJunction)
+        area = area.united(QRectF(nodes[i], nodes[(i + nodes.count() - 1) % nodes.count()]).normalized());
+    if (i < nodes.count() - 1 || type == PlainJunction)
+        area = area.united(QRectF(nodes[i], nodes[(i + 1) % nodes.count()]).normalized());
+    qreal margin = qMax(boundsMargin(), gripRadius * 1.5);
+    return area.adjusted(-margin, -margin, margin, margin);
+}
+
+qreal PathElement::boundsMargin() const
+{
+    // Covers the widest pen, the border path and the direction arrow
+    return qMax(normalW / 2, qreal(0.8)) * M_SQRT2;
 }
 
 void PathElement::mouseReleaseEvent(QGraphicsSceneMouseEvent *)
@@ -173,25 +339,40 @@ void PathElement::mouseReleaseEvent(QGraphicsSceneMouseEvent *)
     // Update the XML domDocument if the node was changed
     if (selectedNode > -1)
     {
+        // Write the turns of the junction once the lane end is released
+        if (type == NormalLane && (selectedNode == 0 || selectedNode == nodes.count() - 1))
+            model->laneEndMoved(this, selectedNode == 0, true);
+
         selectedNode = -1;
+        snapped = false;
+        endDrag();
         updateXML();
-        update();
     }
 }
 
-void PathElement::paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *)
+void PathElement::paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *widget)
 {
-    // Determine if paint colour is red (for selected) or normal
-    QColor colour = (selected ? QColor(255, 0, 0) : QColor(r, g, b));
-    painter->setPen(QPen(colour, (isWired ? wireW : normalW), style, Qt::FlatCap, Qt::BevelJoin));
+    // The view paints static elements into its cached background without a widget,
+    // and only dynamic elements in the item pass over it
+    if (widget && !isDynamic()) return;
+
+    PaintStats::count(paintCategory(), (widget ? PaintStats::ItemPass : PaintStats::BackgroundPass));
+
+    // Determine if paint colour is red (for selected) or normal; blinking inverts it. The
+    // background pass always uses the normal style, so that the cache does not keep the
+    // element red or gripped after it is deselected
+    bool background = (widget == 0);
+    bool red = !background && (selected != blinkOn);
+    QColor colour = (red ? QColor(255, 0, 0) : normalColour());
+    painter->setPen(QPen(colour, (isWired ? wireW : normalW), (lowDetail ? Qt::SolidLine : style), Qt::FlatCap, Qt::BevelJoin));
 
     // Determine fill brush if required
-    if (fill) painter->setBrush(QBrush((selected ? QColor(255, 0, 0, 100) : QColor(r, g, b, 100))));
+    if (fill) painter->setBrush(QBrush((red ? QColor(255, 0, 0, 100) : normalColour(100))));
 
     // Draw the center path
     painter->drawPath(centerPath);
 
-    if (editable && selected)
+    if (editable && selected && !background)
     {
         // Draw border path (only for debugging purposes)
         //painter->setPen(QPen(Qt::black, 0.05));
@@ -209,19 +390,28 @@ void PathElement::paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWi
         {
             painter->setBrush(QColor(192, 0, 0));
             painter->drawEllipse(nodes[selectedNode], gripRadius, gripRadius);
+
+            // Ring around the node while it is snapped to another element
+            if (snapped)
+            {
+                painter->setPen(QPen(Qt::magenta, 0.1));
+                painter->setBrush(Qt::NoBrush);
+                painter->drawEllipse(nodes[selectedNode], gripRadius * 1.4, gripRadius * 1.4);
+            }
         }
     }
 
     // Draw arrow
-    if (showArrow && type != PlainJunction && type != IntJunction)
+    if (showArrow && !lowDetail && type != PlainJunction && type != IntJunction)
     {
-        painter->setPen(QPen(selected ? QColor(192, 0, 0) : Qt::black, 0.1, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
-        painter->setBrush(selected ? QColor(192, 0, 0) : Qt::black);
+        painter->setPen(QPen(red ? QColor(192, 0, 0) : Qt::black, 0.1, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+        painter->setBrush(red ? QColor(192, 0, 0) : Qt::black);
+        if (!arrowValid) calcArrow();
         painter->drawPath(arrow);
     }
 
     // Draw blinking node
-    if (blinkingNode >= 0 && blink % 2 == 1)
+    if (!background && blinkingNode >= 0 && blinkingNode < nodes.count())
     {
         painter->setPen(Qt::NoPen);
         painter->setBrush(QColor(192, 0, 0));
@@ -229,10 +419,92 @@ void PathElement::paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWi
     }
 }
 
+void PathElement::addToBatch(RenderBatch &batch) const
+{
+    // Same pen and brush used by paint() for unselected elements
+    QPen pen(normalColour(), (isWired ? wireW : normalW), style, Qt::FlatCap, Qt::BevelJoin);
+    QBrush brush = (fill ? QBrush(normalColour(100)) : QBrush(Qt::NoBrush));
+    batch.addPolyline(QPolygonF(nodes.toVector()), type == PlainJunction, pen, brush);
+
+    // Direction arrow
+    if (showArrow && type != PlainJunction && type != IntJunction)
+    {
+        if (!arrowValid) calcArrow();
+        batch.addPolyline(arrow.toFillPolygon(QTransform()), true, QPen(Qt::black, 0.1, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin), QBrush(Qt::black));
+    }
+}
+
+void PathElement::setColourOverride(QRgb colour)
+{
+    colourOverride = colour;
+}
+
+QColor PathElement::normalColour(int alpha) const
+{
+    if (qAlpha(colourOverride) == 0)
+        return QColor(r, g, b, alpha);
+    return QColor(qRed(colourOverride), qGreen(colourOverride), qBlue(colourOverride), alpha);
+}
+
+QVector<QPointF> PathElement::snapPoints() const
+{
+    return nodes.toVector();
+}
+
+const QList<QPointF> &PathElement::pathNodes() const
+{
+    return nodes;
+}
+
+qreal PathElement::pathLength() const
+{
+    return polylineLength(nodes);
+}
+
+qreal PathElement::polylineLength(const QList<QPointF> &nodes)
+{
+    qreal total = 0;
+    for (int i = 0; i < nodes.count() - 1; ++i)
+        total += QLineF(nodes[i], nodes[i + 1]).length();
+    return total;
+}
+
+QPointF PathElement::midPoint() const
+{
+    if (nodes.isEmpty()) return QPointF();
+
+    // Walk along the segments until half the length is reached
+    qreal remaining = pathLength() / 2, length;
+    for (int i = 0; i < nodes.count() - 1; ++i)
+    {
+        length = QLineF(nodes[i], nodes[i + 1]).length();
+        if (remaining <= length && length > 0)
+            return nodes[i] + (nodes[i + 1] - nodes[i]) * (remaining / length);
+        remaining -= length;
+    }
+    return nodes.last();
+}
+
+PaintStats::Category PathElement::paintCategory() const
+{
+    switch (type)
+    {
+        case Edge:
+        case EdgeNoShape:   return PaintStats::Edges;
+        case NormalLane:    return PaintStats::Lanes;
+        case IntLane:       return PaintStats::IntLanes;
+        case PlainJunction: return PaintStats::Junctions;
+        case IntJunction:   return PaintStats::IntJunctions;
+        default:            return PaintStats::Connections;
+    }
+}
+
 QPainterPath PathElement::shape() const
 {
     // Implementation required by QGraphicsItem
-    return borderPath;
+    // Picking in the network view does not use it: the view queries the scene index over a
+    // square widened by the pick tolerance and then calls contains
+    return borderPath();
 }
 
 QPainterPath PathElement::centerLine() const
@@ -244,7 +516,14 @@ QPainterPath PathElement::centerLine() const
 QRectF PathElement::boundingRect() const
 {
     // Implementation required by QGraphicsItem
-    return borderPath.boundingRect();
+    // The margin does not depend on the wireframe, so switching it on and off does not change the bounds
+    if (!boundsValid)
+    {
+        qreal margin = boundsMargin();
+        bounds = centerPath.controlPointRect().adjusted(-margin, -margin, margin, margin);
+        boundsValid = true;
+    }
+    return bounds;
 }
 
 void PathElement::calcPaths()
@@ -256,10 +535,17 @@ void PathElement::calcPaths()
         centerPath.lineTo(nodes[i]);
     if (type == PlainJunction) centerPath.closeSubpath();
 
-    // Update border path
-    borderPath = QPainterPath();
-    qreal r = (isWired ? wireW : normalW) / 2;
-    if (r < 0.7) r = 0.7;
+    // The arrow, bounds and segment bounding boxes are recalculated when next requested
+    arrowValid = false;
+    boundsValid = false;
+    segmentsValid = false;
+}
+
+QPainterPath PathElement::borderPath() const
+{
+    // Create border path
+    QPainterPath borderPath;
+    qreal r = halfWidth();
 
     QPointF segmentOffset;
     bool first = true;
@@ -318,21 +604,161 @@ void PathElement::calcPaths()
         borderPath.lineTo(nodes[0] + segmentOffset);
     }
     borderPath.closeSubpath();
+    return borderPath;
+}
 
-    // Update direction arrow
+void PathElement::calcArrow() const
+{
+    // Update direction arrow; only drawn for edges, lanes and connections
+    arrow = QPainterPath();
     if (type != PlainJunction && type !=  IntJunction)
     {
-        QPointF direction, directionP, middle;
+        QPointF direction, directionP, middle, before, after;
         middle = centerPath.pointAtPercent(0.50);
-        direction = unitVector(centerPath.pointAtPercent(0.49), centerPath.pointAtPercent(0.51), false);
-        directionP = unitVector(centerPath.pointAtPercent(0.49), centerPath.pointAtPercent(0.51), true);
-        arrow = QPainterPath();
+        before = centerPath.pointAtPercent(0.49);
+        after = centerPath.pointAtPercent(0.51);
+        direction = unitVector(before, after, false);
+        directionP = unitVector(before, after, true);
         arrow.moveTo(middle + direction);
         arrow.lineTo(middle - direction + 0.8 * directionP);
         arrow.lineTo(middle - direction - 0.8 * directionP);
         arrow.lineTo(middle + direction);
         arrow.closeSubpath();
     }
+    arrowValid = true;
+}
+
+void PathElement::calcSegmentBounds() const
+{
+    // Bounding box of every segment, including the closing segment of junction polygons
+    int segments = nodes.count() - 1 + (type == PlainJunction ? 1 : 0);
+    segmentBounds.resize(segments);
+    for (int i = 0; i < segments; ++i)
+        segmentBounds[i] = QRectF(nodes[i], nodes[(i + 1) % nodes.count()]).normalized();
+    segmentsValid = true;
+}
+
+qreal PathElement::halfWidth() const
+{
+    // Same radius the border path used to have
+    qreal r = (isWired ? wireW : normalW) / 2;
+    return (r < 0.7 ? 0.7 : r);
+}
+
+void PathElement::setPickTolerance(qreal tolerance)
+{
+    pickTolerance = tolerance;
+}
+
+void PathElement::setLowDetail(bool low)
+{
+    lowDetail = low;
+}
+
+qreal PathElement::distanceTo(const QPointF &point) const
+{
+    // Filled polygons are hit anywhere inside them
+    if (fill && centerPath.contains(point)) return 0;
+
+    if (!segmentsValid) calcSegmentBounds();
+    qreal distance = qSqrt(qPow(nodes[0].x() - point.x(), 2) + qPow(nodes[0].y() - point.y(), 2));
+    for (int i = 0; i < segmentBounds.count(); ++i)
+    {
+        // Project the point onto the segment AB and clamp it to the segment ends
+        const QPointF &a = nodes[i];
+        const QPointF &b = nodes[(i + 1) % nodes.count()];
+        qreal dx = b.x() - a.x(), dy = b.y() - a.y();
+        qreal norm2 = dx * dx + dy * dy;
+        qreal t = (norm2 > 0 ? ((point.x() - a.x()) * dx + (point.y() - a.y()) * dy) / norm2 : 0);
+        if (t < 0) t = 0; else if (t > 1) t = 1;
+        qreal ex = a.x() + t * dx - point.x(), ey = a.y() + t * dy - point.y();
+        distance = qMin(distance, qSqrt(ex * ex + ey * ey));
+    }
+    return distance;
+}
+
+bool PathElement::hitTest(const QPointF &point, qreal tolerance) const
+{
+    if (fill && centerPath.contains(point)) return true;
+
+    // Discard segments whose bounding box is further than the tolerance before measuring the distance
+    if (!segmentsValid) calcSegmentBounds();
+    qreal tolerance2 = tolerance * tolerance;
+    for (int i = 0; i < segmentBounds.count(); ++i)
+    {
+        const QRectF &box = segmentBounds[i];
+        if (point.x() < box.left() - tolerance || point.x() > box.right() + tolerance ||
+            point.y() < box.top() - tolerance || point.y() > box.bottom() + tolerance)
+            continue;
+
+        const QPointF &a = nodes[i];
+        const QPointF &b = nodes[(i + 1) % nodes.count()];
+        qreal dx = b.x() - a.x(), dy = b.y() - a.y();
+        qreal norm2 = dx * dx + dy * dy;
+        qreal t = (norm2 > 0 ? ((point.x() - a.x()) * dx + (point.y() - a.y()) * dy) / norm2 : 0);
+        if (t < 0) t = 0; else if (t > 1) t = 1;
+        qreal ex = a.x() + t * dx - point.x(), ey = a.y() + t * dy - point.y();
+        if (ex * ex + ey * ey <= tolerance2) return true;
+    }
+    return false;
+}
+
+bool PathElement::intersectsRect(const QRectF &rect) const
+{
+    if (fill && centerPath.intersects(rect)) return true;
+
+    if (!segmentsValid) calcSegmentBounds();
+    for (int i = 0; i < segmentBounds.count(); ++i)
+    {
+        // Segment boxes can have zero width or height, so compare the coordinates directly
+        const QRectF &box = segmentBounds[i];
+        if (box.right() < rect.left() || box.left() > rect.right() ||
+            box.bottom() < rect.top() || box.top() > rect.bottom())
+            continue;
+
+        // Clip the segment against the rectangle (Liang-Barsky)
+        const QPointF &a = nodes[i];
+        const QPointF &b = nodes[(i + 1) % nodes.count()];
+        qreal dx = b.x() - a.x(), dy = b.y() - a.y();
+        qreal p[4] = { -dx, dx, -dy, dy };
+        qreal q[4] = { a.x() - rect.left(), rect.right() - a.x(), a.y() - rect.top(), rect.bottom() - a.y() };
+        qreal t0 = 0, t1 = 1;
+        bool inside = true;
+        for (int k = 0; k < 4 && inside; ++k)
+        {
+            if (p[k] == 0)
+                inside = (q[k] >= 0);
+            else if (p[k] < 0)
+                t0 = qMax(t0, q[k] / p[k]);
+            else
+                t1 = qMin(t1, q[k] / p[k]);
+            if (t0 > t1) inside = false;
+        }
+        if (inside) return true;
+    }
+    return false;
+}
+
+bool PathElement::contains(const QPointF &point) const
+{
+    // Implementation required by QGraphicsItem
+    return hitTest(point, qMax(halfWidth(), pickTolerance));
+}
+
+bool PathElement::collidesWithPath(const QPainterPath &path, Qt::ItemSelectionMode mode) const
+{
+    // The scene tests items against a rectangle path, e.g. for QGraphicsView::items(QPoint), where it is one pixel wide
+    QRectF rect = path.controlPointRect();
+    qreal tolerance = qMax(halfWidth(), pickTolerance);
+
+    if (mode == Qt::ContainsItemShape || mode == Qt::ContainsItemBoundingRect)
+        return path.contains(centerPath.controlPointRect());
+
+    // Small rectangles (clicks) are tested as a point; larger ones by clipping the segments
+    qreal radius = qSqrt(rect.width() * rect.width() + rect.height() * rect.height()) / 2;
+    if (radius <= tolerance)
+        return hitTest(rect.center(), tolerance + radius);
+    return intersectsRect(rect.adjusted(-tolerance, -tolerance, tolerance, tolerance));
 }
 
 QPointF PathElement::unitVector(QPointF pA, QPointF pB, bool perpendicular) const
@@ -378,11 +804,7 @@ QString PathElement::shapePoints() const
 QString PathElement::length() const
 {
     // Returns the length of the center path in a string format
-    qreal l = 0;
-    for (int i = 1; i < nodes.count(); ++i)
-        l += qSqrt(qPow(nodes[i].x() - nodes[i - 1].x(), 2) + qPow(nodes[i].y() - nodes[i - 1].y(), 2));
-
-    return QString::number(l, 'f', 2);
+    return QString::number(polylineLength(nodes), 'f', 2);
 }
 
 void PathElement::contextMenuEvent(QGraphicsSceneContextMenuEvent *event)
@@ -581,40 +1003,31 @@ void PathElement::updateXML()
         if (type == NormalLane || type == IntLane)
             model->editAttribute(item->xmlNode, item->xmlSubNode, "length", length());
     }
-}
 
-void PathElement::highlight()
-{
-    blink = 0;
-    // Start timer
-    timer.start(100, this);
+    commitGeometry();
 }
 
-void PathElement::highlightPoint(int node)
+void PathElement::commitGeometry()
 {
-    blink = 0;
-    blinkingNode = node;
-    // Start timer
-    timer.start(100, this);
+    // Report the area covered by the element before and after the edit
+    model->notifyGeometryChanged(committedBounds.united(boundingRect()));
+    committedBounds = boundingRect();
+    model->snapIndex()->setPoints(this, snapPoints());
 }
 
-void PathElement::timerEvent(QTimerEvent *)
+void PathElement::setBlink(bool on, int node)
 {
-    // Normally the blink parameter is -1; when the highlight methods are called it is changed to 0
-    if (blink >= 0)
+    if (node < 0)
     {
-        // Every time the timer emits a call, the element is selected or deselected
-        if (blinkingNode < 0) selected = !selected;
+        // The whole element is drawn with the inverse of its selection colour
+        blinkOn = on;
         update();
-        ++blink;
-
-        // After 6 blinks, the timer is stopped
-        if (blink == 6)
-        {
-            timer.stop();
-            blink = -1;
-            blinkingNode = -1;
-        }
+    }
+    else if (node < nodes.count())
+    {
+        // Only the area of the node grip is repainted
+        blinkingNode = (on ? node : -1);
+        update(QRectF(nodes[node].x() - gripRadius, nodes[node].y() - gripRadius, 2 * gripRadius, 2 * gripRadius));
     }
 }
 
@@ -23,14 +23,16 @@
 #define PATHELEMENT_H
 
 #include "model.h"
+#include "renderbatch.h"
+#include "paintstats.h"
 
 #include <QObject>
 #include <QGraphicsPathItem>
 #include <QItemSelectionModel>
 #include <QModelIndex>
-#include <QBasicTimer>
+#include <QVector>
 
-class PathElement : public QGraphicsPathItem, public QObject
+class PathElement : public QGraphicsPathItem
 {
 public:
     // Element type to adjust colour and pens accordingly
@@ -44,6 +46,44 @@ public:
     QPainterPath centerLine() const;
     QRectF boundingRect() const;
 
+    // Hit testing based on the distance to the path segments instead of the shape outline
+    bool contains(const QPointF &point) const;
+    bool collidesWithPath(const QPainterPath &path, Qt::ItemSelectionMode mode = Qt::IntersectsItemShape) const;
+
+    // Returns the distance from a point to the center path (zero inside filled polygons)
+    qreal distanceTo(const QPointF &point) const;
+
+    // Points other shape nodes snap to: all the nodes of the element
+    QVector<QPointF> snapPoints() const;
+
+    // Nodes of the center path
+    const QList<QPointF> &pathNodes() const;
+
+    // Length of the center path, and the point halfway along it
+    qreal pathLength() const;
+    QPointF midPoint() const;
+
+    // Length of a polyline; safe to call from worker threads
+    static qreal polylineLength(const QList<QPointF> &nodes);
+
+    // Sets the pick tolerance in scene units; called by the network view when the zoom changes
+    static void setPickTolerance(qreal tolerance);
+
+    // Switches the low detail drawing (solid lines, no arrows) used by the network view while
+    // the user pans or zooms
+    static void setLowDetail(bool low);
+
+    // Adds the element to a render batch with its normal (unselected) style
+    void addToBatch(RenderBatch &batch) const;
+
+    // Category used in the rendering statistics
+    PaintStats::Category paintCategory() const;
+
+    // Replaces the colour of the element type, e.g. for the attribute heatmap; a transparent
+    // colour (0) restores it. The views are not updated, so that the whole network can be
+    // recoloured before redrawing once
+    void setColourOverride(QRgb colour);
+
     // Index of the Item in the model (tree view)
     QModelIndex modelIndex;
 
@@ -52,12 +92,34 @@ public:
     void deselect();
     bool isSelected() const;
 
-    // Changes an element property
+    // Changes an element property; the caller must refresh the background of the view
+    // (Model::notifyGeometryChanged) when the visibility or the style changes
     void switchState(Model::ElementProperty prop, bool state);
 
-    // Highlights the whole element or point
-    void highlight();
-    void highlightPoint(int node);
+    // Dynamic elements (selected, highlighted or being edited) are painted over the cached
+    // background of the network view; the rest are only painted into the background
+    bool isDynamic() const;
+
+    // Returns true while a node is being dragged; the element is then left out of the background
+    bool isMoving() const;
+
+    // Part of the element moved by follow()
+    enum FollowPart { WholePath, FirstNode, LastNode };
+
+    // Moves the whole element, or one of its end nodes, with a junction that is being dragged;
+    // the element is kept out of the background until endFollow() writes it into the XML domDocument
+    void follow(const QPointF &delta, FollowPart part);
+    void endFollow();
+
+    // Replaces the nodes of the element, e.g. with a regenerated internal lane; also ended by endFollow()
+    void followShape(const QList<QPointF> &nodes);
+
+    // Replaces the nodes as part of a bulk edit that writes the XML itself; neither the background
+    // nor the element is invalidated, the caller reports the whole area to the model once
+    void setNodes(const QList<QPointF> &nodes);
+
+    // Shows or hides the highlight of the whole element (node = -1) or of one node; called by the Animator
+    void setBlink(bool on, int node = -1);
     
     // deletes the selected element
     void deleteElement();
@@ -80,9 +142,6 @@ protected:
     // Reimplemented paint method
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget);
 
-    // Timer event used when highlighting the element
-    void timerEvent(QTimerEvent *event);
-
     // Context menu call
     void contextMenuEvent(QGraphicsSceneContextMenuEvent *event);
 
@@ -92,6 +151,7 @@ private:
     Qt::PenStyle style;
     bool selected, fill, isWired, editable, showArrow;
     int selectedNode;
+    bool following;
     qreal normalW, wireW, z;
     qreal gripRadius;
 
@@ -107,12 +167,62 @@ private:
     // Pointer to the Selection Model, to call it when the item is clicked
     QItemSelectionModel *selectionModel;
 
-    // Center path and border path
-    QPainterPath centerPath, borderPath, arrow;
+    // Center path; the direction arrow, the bounds and the segment bounding boxes are
+    // derived from it on demand and cached until the nodes change
+    QPainterPath centerPath;
+    mutable QPainterPath arrow;
+    mutable QRectF bounds;
+    mutable QVector<QRectF> segmentBounds;
+    mutable bool arrowValid, boundsValid, segmentsValid;
 
-    // Calculates the paths from the current node positions
+    // Calculates the center path from the current node positions and invalidates the derived data
     void calcPaths();
 
+    // Moves one node while it is dragged, updating only the path element, the segment bounding
+    // boxes and the area of its adjacent segments; endDrag() recalculates everything once
+    void moveNode(int i, const QPointF &pos);
+    void endDrag();
+
+    // Area covered by the segments at a node, with its marker
+    QRectF nodeBounds(int i) const;
+
+    // Margin of the bounding rect around the center path
+    qreal boundsMargin() const;
+
+    // Minimum slack added to the bounds when a dragged node leaves them
+    static const int dragSlack = 20;
+
+    // Lazy calculation of the direction arrow and the segment bounding boxes
+    void calcArrow() const;
+    void calcSegmentBounds() const;
+
+    // Builds the offset outline of the path; only used by shape(), so it is never kept in memory
+    QPainterPath borderPath() const;
+
+    // Half of the current pen width, with a minimum so that thin elements can still be clicked
+    qreal halfWidth() const;
+
+    // Returns true if any segment lies within 'tolerance' of the point
+    bool hitTest(const QPointF &point, qreal tolerance) const;
+
+    // Returns true if any segment crosses the rectangle
+    bool intersectsRect(const QRectF &rect) const;
+
+    // Pick tolerance in scene units, shared by all the elements of the network view
+    static qreal pickTolerance;
+
+    // Low detail drawing, shared by all the elements
+    static bool lowDetail;
+
+    // Colour replacing r, g, b when its alpha is not zero
+    QRgb colourOverride;
+
+    // Normal (unselected) colour of the element with the given alpha
+    QColor normalColour(int alpha = 255) const;
+
+    // Marks the area of the element in the cached background of the views to be redrawn
+    void invalidateBackground();
+
     // Returns unit vector for two given points, used in the path calculations
     QPointF unitVector(QPointF pA, QPointF pB, bool perpendicular) const;
 
@@ -122,9 +232,20 @@ private:
     // Point used in mouse movement events
     QPointF lastPos;
 
+    // Unsnapped position of the dragged node, and whether the node is currently snapped
+    QPointF dragPos;
+    bool snapped;
+
     // Updates the shape and length properties in XML domDocument after the nodes have been modified
     void updateXML();
 
+    // Reports the edit to the model and refreshes the snap points of the element
+    void commitGeometry();
+
+    // Bounds of the element when it was last written into the XML domDocument, so that
+    // the model can report the area covered before and after an edit
+    QRectF committedBounds;
+
     // Returns a string with the nodes' coordinates; used by updateXML()
     QString shapePoints() const;
 
@@ -140,9 +261,9 @@ private:
     void pasteFirstNode();
     void pasteLastNode();
 
-    // Timer and properties used for highlighting
-    QBasicTimer timer;
-    int blink, blinkingNode;
+    // Highlight state set by the Animator
+    bool blinkOn;
+    int blinkingNode;
 };
 
 #endif // PATHELEMENT_H
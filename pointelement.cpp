@@ -21,10 +21,13 @@
 
 #include "pointelement.h"
 #include "item.h"
+#include "snapindex.h"
 
 #include <QPen>
+#include <QPainter>
 #include <QBrush>
 #include <QCursor>
+#include <QGraphicsScene>
 #include <QGraphicsSceneMouseEvent>
 #include <QMenu>
 #include <QApplication>
@@ -55,11 +58,14 @@ PointElement::PointElement(ElementType type, qreal x, qreal y, Model *model, Ite
     setRect(x - radius, y - radius, 2 * radius, 2 * radius);
     setPen(QPen(QColor(r, g, b), w));
     setZValue(z);
+    committedBounds = boundingRect();
 
     // Initialise more members
     selected = false;
     editable = false;
     moving = false;
+    blinkOn = false;
+    snapped = false;
 
     // Set arrow cursor
     setCursor(QCursor(Qt::ArrowCursor));
@@ -67,21 +73,71 @@ PointElement::PointElement(ElementType type, qreal x, qreal y, Model *model, Ite
     update();
 }
 
+void PointElement::addToBatch(RenderBatch &batch) const
+{
+    batch.addEllipse(QPointF(x, y), radius, QPen(QColor(r, g, b), w));
+}
+
+QPointF PointElement::position() const
+{
+    return QPointF(x, y);
+}
+
+QVector<QPointF> PointElement::snapPoints() const
+{
+    return QVector<QPointF>() << QPointF(x, y);
+}
+
+PaintStats::Category PointElement::paintCategory() const
+{
+    switch (type)
+    {
+        case PlainJunction: return PaintStats::Junctions;
+        case IntJunction:   return PaintStats::IntJunctions;
+        default:            return PaintStats::Connections;
+    }
+}
+
+void PointElement::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    // Static elements are only painted into the cached background of the view
+    if (widget && !isDynamic()) return;
+
+    PaintStats::count(paintCategory(), (widget ? PaintStats::ItemPass : PaintStats::BackgroundPass));
+
+    // The background pass always uses the normal colour, so that the cache does not keep
+    // the element red after it is deselected
+    if (!widget)
+    {
+        painter->setPen(QPen(QColor(r, g, b), w));
+        painter->setBrush(brush());
+        painter->drawEllipse(rect());
+        return;
+    }
+    QGraphicsEllipseItem::paint(painter, option, widget);
+
+    // Ring around the element while it is snapped to another element
+    if (snapped)
+    {
+        painter->setPen(QPen(Qt::magenta, 0.05));
+        painter->setBrush(Qt::NoBrush);
+        painter->drawEllipse(QPointF(x, y), radius * 1.3, radius * 1.3);
+    }
+}
+
 void PointElement::select()
 {
-    // Set selected as true, set colour as red, bring element to front and redraw
+    // Set selected as true, set colour as red and redraw over the cached background
     selected = true;
     setPen(QPen(QColor(255, 0, 0), w));
-    setZValue(10);
     update();
 }
 
 void PointElement::deselect()
 {
-    // Set selected as false, set normal colour, put element back into its normal position and redraw
+    // Set selected as false, set normal colour and redraw
     selected = false;
     setPen(QPen(QColor(r, g, b), w));
-    setZValue(z);
     update();
 }
 
@@ -90,9 +146,19 @@ bool PointElement::isSelected() const
     return selected;
 }
 
+bool PointElement::isDynamic() const
+{
+    return selected || blinkOn || moving;
+}
+
+bool PointElement::isMoving() const
+{
+    return moving;
+}
+
 void PointElement::switchState(Model::ElementProperty prop, bool state)
 {
-    // Change element property
+    // Change element property; the cached background is refreshed by the caller
     switch (prop)
     {
     case Model::ViewElement:
@@ -108,19 +174,18 @@ void PointElement::switchState(Model::ElementProperty prop, bool state)
 
 void PointElement::mousePressEvent(QGraphicsSceneMouseEvent *event)
 {
-    selected = true;
-
-    // Prepare the element to be moved
-    if (editable)
+    // Prepare the element to be moved if it is selected; the network view selects the element
+    // ranked first under the click
+    if (selected && editable)
     {
         moving = true;
         lastPos = event->pos();
+        dragPos = QPointF(x, y);
+
+        // Take the element out of the background while it is moved
+        if (scene()) scene()->invalidate(sceneBoundingRect(), QGraphicsScene::BackgroundLayer);
         update();
     }
-
-    // Select the element in the tree and trigger all the selection processes
-    if (selectionModel)
-        selectionModel->select(modelIndex, QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows);
 }
 
 void PointElement::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
@@ -128,12 +193,24 @@ void PointElement::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
     // Move the element if previously clicked on it (and is in edit state)
     if (moving)
     {
-        x += event->pos().x() - lastPos.x();
-        y += event->pos().y() - lastPos.y();
+        dragPos += event->pos() - lastPos;
         lastPos = event->pos();
+
+        // Snap to the nearest point of another element unless Alt is held; plain junctions
+        // carry their attached geometry with them and are moved freely
+        QPointF target;
+        snapped = type != PlainJunction && !(event->modifiers() & Qt::AltModifier)
+                  && model->snapIndex()->nearest(dragPos, this, target);
+        if (!snapped) target = dragPos;
+        QPointF delta(target.x() - x, target.y() - y);
+        x = target.x();
+        y = target.y();
         prepareGeometryChange();
         setRect(x - radius, y - radius, 2 * radius, 2 * radius);
         update();
+
+        // Move the lanes, polygon, internal lanes and connections of the junction with it
+        if (type == PlainJunction) model->moveJunction(item, delta);
     }
 }
 
@@ -143,7 +220,13 @@ void PointElement::mouseReleaseEvent(QGraphicsSceneMouseEvent *)
     if (moving)
     {
         moving = false;
+        snapped = false;
+
+        // The junction and its attached elements are written as one update
+        model->beginUpdate();
         updateXML();
+        if (type == PlainJunction) model->commitJunctionMove(item);
+        model->endUpdate();
         update();
     }
 }
@@ -157,6 +240,54 @@ void PointElement::updateXML()
         model->editAttribute(item->xmlNode, item->xmlSubNode, "x",  QString::number(x, 'f', 2));
         model->editAttribute(item->xmlNode, item->xmlSubNode, "y",  QString::number(y, 'f', 2));
     }
+
+    commitGeometry();
+}
+
+void PointElement::commitGeometry()
+{
+    // Report the area covered by the element before and after the move
+    model->notifyGeometryChanged(committedBounds.united(boundingRect()));
+    committedBounds = boundingRect();
+    model->snapIndex()->setPoints(this, snapPoints());
+}
+
+void PointElement::follow(const QPointF &delta)
+{
+    // Take the element out of the background on the first move
+    if (!moving)
+    {
+        moving = true;
+        if (scene()) scene()->invalidate(sceneBoundingRect(), QGraphicsScene::BackgroundLayer);
+    }
+
+    x += delta.x();
+    y += delta.y();
+    prepareGeometryChange();
+    setRect(x - radius, y - radius, 2 * radius, 2 * radius);
+    update();
+}
+
+void PointElement::endFollow()
+{
+    if (!moving) return;
+    moving = false;
+
+    // Connection points are drawn from the lanes and have no position to write
+    if (type == Connection)
+        commitGeometry();
+    else
+        updateXML();
+    update();
+}
+
+void PointElement::setPosition(const QPointF &position)
+{
+    x = position.x();
+    y = position.y();
+    setRect(x - radius, y - radius, 2 * radius, 2 * radius);
+    committedBounds = boundingRect();
+    model->snapIndex()->setPoints(this, snapPoints());
 }
 
 void PointElement::contextMenuEvent(QGraphicsSceneContextMenuEvent *event)
@@ -221,34 +352,14 @@ void PointElement::deleteElement()
     }
 }
 
-void PointElement::highlight()
+void PointElement::setBlink(bool on)
 {
-    blink = 0;
-
-    // Start timer
-    timer.start(100, this);
-}
-
-void PointElement::timerEvent(QTimerEvent *)
-{
-    // Normally the blink parameter is -1; when the highlight methods are called it is changed to 0
-    if (blink >= 0)
-    {
-        // Every time the timer emits a call, the element is selected or deselected
-        if (selected) deselect(); else select();
-        update();
-        ++blink;
-
-        // After 6 blinks, the timer is stopped
-        if (blink == 6)
-        {
-            timer.stop();
-            blink = -1;
-        }
-    }
+    // The element is drawn with the inverse of its selection colour
+    blinkOn = on;
+    setPen(QPen((selected != blinkOn) ? QColor(255, 0, 0) : QColor(r, g, b), w));
+    update();
 }
 
-
 Item* PointElement::getItem()
 {
   return item;
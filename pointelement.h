@@ -23,14 +23,15 @@
 #define POINTELEMENT_H
 
 #include "model.h"
+#include "renderbatch.h"
+#include "paintstats.h"
 
 #include <QObject>
 #include <QGraphicsEllipseItem>
 #include <QItemSelectionModel>
 #include <QModelIndex>
-#include <QBasicTimer>
 
-class PointElement : public QGraphicsEllipseItem, public QObject
+class PointElement : public QGraphicsEllipseItem
 {
 public:
     // Element type to adjust colour and pens accordingly
@@ -47,11 +48,40 @@ public:
     void deselect();
     bool isSelected() const;
 
-    // Changes an element property
+    // Changes an element property; the caller must refresh the background of the view
+    // (Model::notifyGeometryChanged) when the visibility or the style changes
     void switchState(Model::ElementProperty prop, bool state);
 
-    // Highlights the element
-    void highlight();
+    // Dynamic elements (selected, highlighted or being moved) are painted over the cached
+    // background of the network view; the rest are only painted into the background
+    bool isDynamic() const;
+
+    // Returns true while the element is being moved; it is then left out of the background
+    bool isMoving() const;
+
+    // Moves the element with a junction that is being dragged; the element is kept out of the
+    // background until endFollow() writes it into the XML domDocument
+    void follow(const QPointF &delta);
+    void endFollow();
+
+    // Moves the element as part of a bulk edit that writes the XML itself; neither the background
+    // nor the element is invalidated, the caller reports the whole area to the model once
+    void setPosition(const QPointF &position);
+
+    // Shows or hides the highlight of the element; called by the Animator
+    void setBlink(bool on);
+
+    // Position of the element
+    QPointF position() const;
+
+    // Points the shape nodes snap to: the position of the element
+    QVector<QPointF> snapPoints() const;
+
+    // Adds the element to a render batch with its normal (unselected) style
+    void addToBatch(RenderBatch &batch) const;
+
+    // Category used in the rendering statistics
+    PaintStats::Category paintCategory() const;
 
     // deletes the selected element
     void deleteElement();
@@ -71,8 +101,8 @@ protected:
     void mouseMoveEvent(QGraphicsSceneMouseEvent *event);
     void mouseReleaseEvent(QGraphicsSceneMouseEvent *);
 
-    // Timer event used when highlighting the element
-    void timerEvent(QTimerEvent *event);
+    // Reimplemented paint method, to count the calls in the rendering statistics
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget);
 
     // Context menu call
     void contextMenuEvent(QGraphicsSceneContextMenuEvent *event);
@@ -92,16 +122,25 @@ private:
     // Point used in mouse movement events
     QPointF lastPos;
 
+    // Unsnapped position while the element is moved, and whether it is currently snapped
+    QPointF dragPos;
+    bool snapped;
+
     // Updates the x and y properties in XML domDocument after the nodes have been modified
     void updateXML();
 
+    // Reports the edit to the model and refreshes the snap point of the element
+    void commitGeometry();
+
+    // Bounds of the element when it was last written into the XML domDocument
+    QRectF committedBounds;
+
     // Context menu actions
     void copyCoords();
     void pasteCoords();
 
-    // Timer and properties used for highlighting
-    QBasicTimer timer;
-    int blink;
+    // Highlight state set by the Animator
+    bool blinkOn;
 };
 
 #endif // POINTELEMENT_H
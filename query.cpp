@@ -0,0 +1,481 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#include "query.h"
+#include "item.h"
+
+#include <QObject>
+#include <QDomNamedNodeMap>
+#include <QtConcurrentMap>
+#include <qnumeric.h>
+
+// Key of the XML location of an element
+static qint64 locationKey(int xmlNode, int xmlSubNode)
+{
+    return (qint64(xmlNode) << 32) | quint32(xmlSubNode);
+}
+
+QueryTable::QueryTable(const QVector<Item*> &items, const QVector<QDomElement> &elements) : items(items)
+{
+    for (int row = 0; row < items.count(); ++row)
+        locations.insert(locationKey(items[row]->xmlNode, items[row]->xmlSubNode), row);
+
+    // Collect the values of each attribute; elements without it get an empty value
+    int rows = elements.count();
+    QHash<QString, QVector<QString> > values;
+    for (int row = 0; row < rows; ++row)
+    {
+        QDomNamedNodeMap attributes = elements[row].attributes();
+        for (int a = 0; a < attributes.count(); ++a)
+        {
+            QDomAttr attribute = attributes.item(a).toAttr();
+            QVector<QString> &column = values[attribute.name()];
+            if (column.isEmpty()) column.resize(rows);
+            column[row] = attribute.value();
+        }
+    }
+
+    // Attributes whose values are all numbers become numeric columns, and the rest are coded
+    QHash<QString, QVector<QString> >::const_iterator it;
+    for (it = values.constBegin(); it != values.constEnd(); ++it)
+    {
+        const QVector<QString> &text = it.value();
+        Column column;
+        column.numeric = false;
+        column.numbers.resize(rows);
+        bool ok = true;
+        for (int row = 0; row < rows && ok; ++row)
+        {
+            if (text[row].isEmpty())
+                column.numbers[row] = qQNaN();
+            else
+            {
+                column.numbers[row] = text[row].toFloat(&ok);
+                column.numeric = true;
+            }
+        }
+
+        if (!ok || !column.numeric)
+        {
+            column.numeric = false;
+            column.numbers.clear();
+            column.codes.resize(rows);
+            QHash<QString, int> &codes = column.dictionaryCodes;
+            for (int row = 0; row < rows; ++row)
+            {
+                QHash<QString, int>::const_iterator code = codes.constFind(text[row]);
+                if (code == codes.constEnd())
+                {
+                    code = codes.insert(text[row], column.dictionary.count());
+                    column.dictionary.append(text[row]);
+                }
+                column.codes[row] = code.value();
+            }
+        }
+        columns.insert(it.key(), column);
+    }
+}
+
+void QueryTable::addColumn(const QString &name, const QVector<float> &values)
+{
+    Column column;
+    column.numeric = true;
+    column.numbers = values;
+    columns.insert(name, column);
+}
+
+int QueryTable::rowCount() const
+{
+    return items.count();
+}
+
+Item *QueryTable::item(int row) const
+{
+    return items[row];
+}
+
+const QueryTable::Column *QueryTable::column(const QString &name) const
+{
+    QHash<QString, Column>::const_iterator it = columns.constFind(name);
+    return (it == columns.constEnd() ? 0 : &it.value());
+}
+
+int QueryTable::findRow(int xmlNode, int xmlSubNode) const
+{
+    return locations.value(locationKey(xmlNode, xmlSubNode), -1);
+}
+
+bool QueryTable::setValue(int row, const QString &name, const QString &text)
+{
+    QHash<QString, Column>::iterator it = columns.find(name);
+    if (it == columns.end()) return false;
+    Column &column = it.value();
+
+    // Numeric columns take numbers or a missing value; a text would turn the column into a coded one
+    if (column.numeric)
+    {
+        if (text.isEmpty())
+        {
+            column.numbers[row] = qQNaN();
+            return true;
+        }
+        bool ok;
+        float number = text.toFloat(&ok);
+        if (ok) column.numbers[row] = number;
+        return ok;
+    }
+
+    // Coded columns take a new dictionary entry for a new text
+    QHash<QString, int>::const_iterator code = column.dictionaryCodes.constFind(text);
+    if (code == column.dictionaryCodes.constEnd())
+    {
+        code = column.dictionaryCodes.insert(text, column.dictionary.count());
+        column.dictionary.append(text);
+    }
+    column.codes[row] = code.value();
+    return true;
+}
+
+Query::Query()
+{
+    table = 0;
+    next = 0;
+}
+
+bool Query::compile(const QString &text, QString &error)
+{
+    program.clear();
+    elementKind.clear();
+    table = 0;
+    if (!tokenize(text, tokens, error)) return false;
+
+    next = 0;
+    if (tokens.isEmpty())
+        fail(QObject::tr("The query is empty"));
+    else if (parseOr() && next < tokens.count())
+        fail(QObject::tr("Unexpected '%1'").arg(tokens[next]));
+    else if (parseError.isEmpty() && elementKind.isEmpty())
+        fail(QObject::tr("Name the type of element of an attribute, e.g. lane.speed"));
+
+    error = parseError;
+    parseError.clear();
+    return error.isEmpty();
+}
+
+QString Query::kind() const
+{
+    return elementKind;
+}
+
+bool Query::bind(const QueryTable *table, QString &error)
+{
+    this->table = table;
+    for (int i = 0; i < program.count(); ++i)
+    {
+        Node &node = program[i];
+        if (node.op != Node::Test) continue;
+
+        node.column = table->column(node.attribute);
+        if (!node.column)
+        {
+            error = QObject::tr("No %1 has the attribute '%2'").arg(elementKind).arg(node.attribute);
+            return false;
+        }
+
+        if (node.column->numeric)
+        {
+            bool ok = true;
+            if (!node.isNumber) node.number = node.text.toFloat(&ok);
+            if (!ok || node.compare == Contains)
+            {
+                error = QObject::tr("'%1' holds numbers; compare it with ==, !=, <, <=, > or >=").arg(node.attribute);
+                return false;
+            }
+        }
+        else
+        {
+            // Comparing each dictionary entry once leaves a table lookup per row; the empty entry
+            // stands for the missing values, which match nothing
+            const QStringList &dictionary = node.column->dictionary;
+            node.codeMatches.resize(dictionary.count());
+            for (int code = 0; code < dictionary.count(); ++code)
+                node.codeMatches[code] = !dictionary[code].isEmpty() && compareText(dictionary[code], node.compare, node.text);
+        }
+    }
+    return true;
+}
+
+QVector<int> Query::evaluate() const
+{
+    QVector<int> rows;
+    if (!table || program.isEmpty()) return rows;
+
+    QList<int> blocks;
+    for (int first = 0; first < table->rowCount(); first += blockSize)
+        blocks.append(first);
+
+    Block block;
+    block.query = this;
+    QList<QVector<int> > results = QtConcurrent::blockingMapped(blocks, block);
+    for (int i = 0; i < results.count(); ++i)
+        rows += results[i];
+    return rows;
+}
+
+QVector<int> Query::Block::operator()(int first) const
+{
+    // The expression is evaluated one node at a time over the whole block, so that each
+    // comparison is a tight loop over a column
+    int count = qMin(int(blockSize), query->table->rowCount() - first);
+    QVector<QVector<char> > stack;
+    for (int n = 0; n < query->program.count(); ++n)
+    {
+        const Node &node = query->program[n];
+        if (node.op == Node::Test)
+        {
+            QVector<char> result(count);
+            char *out = result.data();
+            if (node.column->numeric)
+            {
+                const float *v = node.column->numbers.constData() + first;
+                float x = node.number;
+
+                // Missing values are NaN, which fails every comparison but '!=', so that one checks them
+                switch (node.compare)
+                {
+                    case Equal:         for (int i = 0; i < count; ++i) out[i] = (v[i] == x); break;
+                    case NotEqual:      for (int i = 0; i < count; ++i) out[i] = (v[i] == v[i] && v[i] != x); break;
+                    case Less:          for (int i = 0; i < count; ++i) out[i] = (v[i] < x); break;
+                    case LessEqual:     for (int i = 0; i < count; ++i) out[i] = (v[i] <= x); break;
+                    case Greater:       for (int i = 0; i < count; ++i) out[i] = (v[i] > x); break;
+                    case GreaterEqual:  for (int i = 0; i < count; ++i) out[i] = (v[i] >= x); break;
+                    case Contains:      break;
+                }
+            }
+            else
+            {
+                const int *c = node.column->codes.constData() + first;
+                const char *matches = node.codeMatches.constData();
+                for (int i = 0; i < count; ++i) out[i] = matches[c[i]];
+            }
+            stack.append(result);
+            continue;
+        }
+
+        if (node.op == Node::Not)
+        {
+            char *a = stack.last().data();
+            for (int i = 0; i < count; ++i) a[i] = !a[i];
+            continue;
+        }
+
+        QVector<char> right = stack.takeLast();
+        const char *b = right.constData();
+        char *a = stack.last().data();
+        if (node.op == Node::And)
+            for (int i = 0; i < count; ++i) a[i] = a[i] & b[i];
+        else
+            for (int i = 0; i < count; ++i) a[i] = a[i] | b[i];
+    }
+
+    QVector<int> rows;
+    const char *result = stack.last().constData();
+    for (int i = 0; i < count; ++i)
+        if (result[i]) rows.append(first + i);
+    return rows;
+}
+
+bool Query::parseOr()
+{
+    if (!parseAnd()) return false;
+    while (accept("or") || accept("||"))
+    {
+        if (!parseAnd()) return false;
+        Node node;
+        node.op = Node::Or;
+        program.append(node);
+    }
+    return true;
+}
+
+bool Query::parseAnd()
+{
+    if (!parseNot()) return false;
+    while (accept("and") || accept("&&"))
+    {
+        if (!parseNot()) return false;
+        Node node;
+        node.op = Node::And;
+        program.append(node);
+    }
+    return true;
+}
+
+bool Query::parseNot()
+{
+    if (accept("not") || accept("!"))
+    {
+        if (!parseNot()) return false;
+        Node node;
+        node.op = Node::Not;
+        program.append(node);
+        return true;
+    }
+    return parseTest();
+}
+
+bool Query::parseTest()
+{
+    if (accept("("))
+    {
+        if (!parseOr()) return false;
+        if (!accept(")")) return fail(QObject::tr("Missing ')'"));
+        return true;
+    }
+
+    // Attribute, optionally preceded by the type of element
+    if (next >= tokens.count()) return fail(QObject::tr("The query ends too early"));
+    QString name = tokens[next++];
+    if (!name[0].isLetter() && name[0] != '_') return fail(QObject::tr("Expected an attribute instead of '%1'").arg(name));
+    int dot = name.indexOf('.');
+    if (dot >= 0)
+    {
+        QString kind = name.left(dot).toLower();
+        static const QStringList kinds = QStringList() << "edge" << "lane" << "junction" << "connection" << "tllogic";
+        if (!kinds.contains(kind)) return fail(QObject::tr("Unknown type of element '%1'").arg(name.left(dot)));
+        if (!elementKind.isEmpty() && kind != elementKind) return fail(QObject::tr("A query can only test one type of element"));
+        elementKind = kind;
+        name = name.mid(dot + 1);
+    }
+
+    Node node;
+    node.op = Node::Test;
+    node.attribute = name;
+    node.column = 0;
+    if (accept("==") || accept("=")) node.compare = Equal;
+    else if (accept("!=")) node.compare = NotEqual;
+    else if (accept("<=")) node.compare = LessEqual;
+    else if (accept(">=")) node.compare = GreaterEqual;
+    else if (accept("<")) node.compare = Less;
+    else if (accept(">")) node.compare = Greater;
+    else if (accept("contains")) node.compare = Contains;
+    else return fail(QObject::tr("Expected a comparison after '%1'").arg(name));
+
+    // Quoted strings, numbers, and bare words such as traffic_light
+    if (next >= tokens.count()) return fail(QObject::tr("The query ends too early"));
+    QString value = tokens[next++];
+    if (value[0] == '"' || value[0] == '\'')
+    {
+        node.text = value.mid(1);
+        node.isNumber = false;
+    }
+    else
+    {
+        if (value == "(" || value == ")") return fail(QObject::tr("Expected a value after '%1'").arg(name));
+        node.text = value;
+        node.number = value.toFloat(&node.isNumber);
+    }
+    program.append(node);
+    return true;
+}
+
+bool Query::accept(const QString &token)
+{
+    if (next < tokens.count() && tokens[next].compare(token, Qt::CaseInsensitive) == 0)
+    {
+        ++next;
+        return true;
+    }
+    return false;
+}
+
+bool Query::fail(const QString &message)
+{
+    if (parseError.isEmpty()) parseError = message;
+    return false;
+}
+
+bool Query::tokenize(const QString &text, QStringList &tokens, QString &error)
+{
+    tokens.clear();
+    int i = 0;
+    while (i < text.length())
+    {
+        QChar c = text[i];
+        if (c.isSpace())
+        {
+            ++i;
+            continue;
+        }
+
+        int start = i;
+        if (c == '"' || c == '\'')
+        {
+            int end = text.indexOf(c, i + 1);
+            if (end < 0)
+            {
+                error = QObject::tr("Missing closing quote");
+                return false;
+            }
+            tokens.append(text.mid(start, end - start));
+            i = end + 1;
+        }
+        else if (c.isLetterOrNumber() || c == '_' || c == '.' || c == '-')
+        {
+            // Names (with the element type), numbers and bare words
+            while (i < text.length() && (text[i].isLetterOrNumber() || text[i] == '_' || text[i] == '.' || text[i] == '-' || text[i] == '+'))
+                ++i;
+            tokens.append(text.mid(start, i - start));
+        }
+        else
+        {
+            static const QStringList operators = QStringList() << "==" << "!=" << "<=" << ">=" << "&&" << "||"
+                                                              << "=" << "<" << ">" << "!" << "(" << ")";
+            int op = 0;
+            while (op < operators.count() && text.mid(i, operators[op].length()) != operators[op]) ++op;
+            if (op == operators.count())
+            {
+                error = QObject::tr("Unexpected character '%1'").arg(c);
+                return false;
+            }
+            tokens.append(operators[op]);
+            i += operators[op].length();
+        }
+    }
+    return true;
+}
+
+bool Query::compareText(const QString &value, Compare compare, const QString &text)
+{
+    switch (compare)
+    {
+        case Equal:         return value == text;
+        case NotEqual:      return value != text;
+        case Less:          return value < text;
+        case LessEqual:     return value <= text;
+        case Greater:       return value > text;
+        case GreaterEqual:  return value >= text;
+        case Contains:
+            if (text.contains(' ')) return value.contains(text);
+            return value.split(' ', QString::SkipEmptyParts).contains(text);
+    }
+    return false;
+}
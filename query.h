@@ -0,0 +1,156 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#ifndef QUERY_H
+#define QUERY_H
+
+#include <QVector>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QDomElement>
+
+class Item;
+
+// Attributes of one kind of element stored as typed columns, built once from the XML so that
+// queries compare numbers and string codes instead of reading QDomElement attributes
+class QueryTable
+{
+public:
+    // Column of numbers (NaN when missing), or of strings coded as positions in a dictionary;
+    // a missing string is the empty string
+    struct Column
+    {
+        bool numeric;
+        QVector<float> numbers;
+        QVector<int> codes;
+        QStringList dictionary;
+        QHash<QString, int> dictionaryCodes;
+    };
+
+    // Builds the columns of all the attributes found in the elements, one row per item
+    QueryTable(const QVector<Item*> &items, const QVector<QDomElement> &elements);
+
+    // Adds a numeric column computed by the model, e.g. the degree of the junctions
+    void addColumn(const QString &name, const QVector<float> &values);
+
+    // Table access; column() returns 0 if no element has the attribute
+    int rowCount() const;
+    Item *item(int row) const;
+    const Column *column(const QString &name) const;
+
+    // Returns the row of an XML element, or -1
+    int findRow(int xmlNode, int xmlSubNode) const;
+
+    // Changes a value after the attribute was edited; returns false if the table has to be built
+    // again, i.e. if no element had the attribute or a numeric column receives a text
+    bool setValue(int row, const QString &name, const QString &text);
+
+private:
+    QVector<Item*> items;
+    QHash<QString, Column> columns;
+
+    // Row of each XML element, keyed by node and subnode
+    QHash<qint64, int> locations;
+};
+
+// Expression over the attributes of one kind of element, e.g.
+// lane.speed > 13.9 and lane.allow contains "bus"
+class Query
+{
+public:
+    // Constructor
+    Query();
+
+    // Parses an expression; returns false and sets 'error' if it is not valid
+    bool compile(const QString &text, QString &error);
+
+    // Kind of element named in the expression: edge, lane, junction, connection or tllogic
+    QString kind() const;
+
+    // Resolves the attributes to the columns of a table, converting the values to the column
+    // types; returns false and sets 'error' if an attribute cannot be compared
+    bool bind(const QueryTable *table, QString &error);
+
+    // Evaluates the expression over all the rows of the bound table, in parallel over blocks
+    // of rows; returns the matching rows in ascending order
+    QVector<int> evaluate() const;
+
+private:
+    // Comparisons; 'contains' matches a word of space separated lists such as 'allow'. An element
+    // without the attribute fails every comparison, '!=' included, so 'not' is needed to select it
+    enum Compare { Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual, Contains };
+
+    // Expression node, stored in postfix order
+    struct Node
+    {
+        enum Op { Test, And, Or, Not };
+        Op op;
+
+        // Comparison of an attribute with a value
+        QString attribute;
+        Compare compare;
+        QString text;
+        bool isNumber;
+        float number;
+
+        // Bound column and, for string columns, the result of the comparison for each dictionary entry
+        const QueryTable::Column *column;
+        QVector<char> codeMatches;
+    };
+
+    // Evaluates a block of rows; runs in a worker thread
+    struct Block
+    {
+        typedef QVector<int> result_type;
+        const Query *query;
+        QVector<int> operator()(int first) const;
+    };
+
+    // Rows evaluated per block
+    static const int blockSize = 16384;
+
+    QVector<Node> program;
+    QString elementKind;
+    const QueryTable *table;
+
+    // Parser state: tokens of the expression and position of the next one
+    QStringList tokens;
+    int next;
+    QString parseError;
+
+    // Recursive descent parser, one function per precedence level
+    bool parseOr();
+    bool parseAnd();
+    bool parseNot();
+    bool parseTest();
+    bool accept(const QString &token);
+    bool fail(const QString &message);
+
+    // Splits an expression into names, numbers, quoted strings, operators and parentheses;
+    // strings keep their opening quote so that they are told apart from names
+    static bool tokenize(const QString &text, QStringList &tokens, QString &error);
+
+    // Result of a comparison of two strings
+    static bool compareText(const QString &value, Compare compare, const QString &text);
+};
+
+#endif // QUERY_H
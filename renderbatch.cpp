@@ -0,0 +1,130 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#include "renderbatch.h"
+#include "pathelement.h"
+#include "pointelement.h"
+
+#include <QPainter>
+#include <QGraphicsScene>
+#include <QGraphicsItem>
+
+RenderBatch::RenderBatch()
+{
+}
+
+void RenderBatch::addScene(QGraphicsScene *scene, const QRectF &rect)
+{
+    // Collect the items in ascending stacking order so that they are painted as in the view
+    QList<QGraphicsItem *> itemList;
+    if (rect.isNull())
+        itemList = scene->items(Qt::AscendingOrder);
+    else
+        itemList = scene->items(rect, Qt::IntersectsItemBoundingRect, Qt::AscendingOrder);
+
+    PathElement *pathit;
+    PointElement *pointit;
+    for (int i = 0; i < itemList.count(); ++i)
+    {
+        if (!itemList[i]->isVisible()) continue;
+
+        pathit = dynamic_cast <PathElement*>(itemList[i]);
+        if (pathit != NULL)
+        {
+            pathit->addToBatch(*this);
+            continue;
+        }
+        pointit = dynamic_cast <PointElement*>(itemList[i]);
+        if (pointit != NULL)
+            pointit->addToBatch(*this);
+    }
+}
+
+void RenderBatch::addPolyline(const QPolygonF &points, bool closed, const QPen &pen, const QBrush &brush)
+{
+    Primitive primitive;
+    primitive.points = points;
+    primitive.radius = 0;
+    primitive.closed = closed;
+    primitive.ellipse = false;
+    primitive.pen = pen;
+    primitive.brush = brush;
+
+    // Extend the bounds by the pen width, so that tiles include strokes crossing their borders
+    qreal w = pen.widthF();
+    primitive.bounds = points.boundingRect().adjusted(-w, -w, w, w);
+    extent |= primitive.bounds;
+
+    primitives.append(primitive);
+}
+
+void RenderBatch::addEllipse(const QPointF &center, qreal radius, const QPen &pen, const QBrush &brush)
+{
+    Primitive primitive;
+    primitive.center = center;
+    primitive.radius = radius;
+    primitive.closed = true;
+    primitive.ellipse = true;
+    primitive.pen = pen;
+    primitive.brush = brush;
+
+    qreal r = radius + pen.widthF();
+    primitive.bounds = QRectF(center.x() - r, center.y() - r, 2 * r, 2 * r);
+    extent |= primitive.bounds;
+
+    primitives.append(primitive);
+}
+
+void RenderBatch::paint(QPainter *painter, const QRectF &exposed) const
+{
+    for (int i = 0; i < primitives.count(); ++i)
+    {
+        const Primitive &primitive = primitives[i];
+        if (!primitive.bounds.intersects(exposed)) continue;
+
+        painter->setPen(primitive.pen);
+        painter->setBrush(primitive.brush);
+        if (primitive.ellipse)
+            painter->drawEllipse(primitive.center, primitive.radius, primitive.radius);
+        else if (primitive.closed)
+            painter->drawPolygon(primitive.points);
+        else if (primitive.brush.style() != Qt::NoBrush)
+        {
+            // Open filled paths (internal junctions): fill as a polygon, stroke as a polyline
+            painter->setPen(Qt::NoPen);
+            painter->drawPolygon(primitive.points);
+            painter->setPen(primitive.pen);
+            painter->drawPolyline(primitive.points);
+        }
+        else
+            painter->drawPolyline(primitive.points);
+    }
+}
+
+QRectF RenderBatch::boundingRect() const
+{
+    return extent;
+}
+
+int RenderBatch::count() const
+{
+    return primitives.count();
+}
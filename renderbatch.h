@@ -0,0 +1,81 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#ifndef RENDERBATCH_H
+#define RENDERBATCH_H
+
+#include <QVector>
+#include <QPolygonF>
+#include <QPen>
+#include <QBrush>
+#include <QRectF>
+
+QT_BEGIN_NAMESPACE
+class QPainter;
+class QGraphicsScene;
+QT_END_NAMESPACE
+
+class RenderBatch
+{
+public:
+    // Constructor
+    RenderBatch();
+
+    // Adds the visible Path and Point Elements of the scene within 'rect' (the whole scene if
+    // the rect is null), in stacking order
+    void addScene(QGraphicsScene *scene, const QRectF &rect = QRectF());
+
+    // Adds a polyline (or polygon if closed) and an ellipse; called by the graphic elements
+    void addPolyline(const QPolygonF &points, bool closed, const QPen &pen, const QBrush &brush = Qt::NoBrush);
+    void addEllipse(const QPointF &center, qreal radius, const QPen &pen, const QBrush &brush = Qt::NoBrush);
+
+    // Paints the primitives intersecting 'exposed' (in scene coordinates)
+    // The batch only holds plain polygons, pens and brushes, so several threads can paint
+    // the same batch at the same time into their own images
+    void paint(QPainter *painter, const QRectF &exposed) const;
+
+    // Bounding rectangle of all the primitives, including pen widths
+    QRectF boundingRect() const;
+
+    // Number of primitives in the batch
+    int count() const;
+
+private:
+    // Drawing primitive: a polyline, polygon or circle with its pen and brush
+    struct Primitive
+    {
+        QPolygonF points;
+        QPointF center;
+        qreal radius;
+        bool closed, ellipse;
+        QPen pen;
+        QBrush brush;
+        QRectF bounds;
+    };
+
+    // List of primitives in painting order
+    QVector<Primitive> primitives;
+
+    // Union of the primitive bounds
+    QRectF extent;
+};
+
+#endif // RENDERBATCH_H
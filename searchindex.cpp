@@ -0,0 +1,241 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#include "searchindex.h"
+
+#include <QSet>
+#include <QtAlgorithms>
+
+// Orders id positions by their keys, for the sorted list of the prefix search
+struct KeyOrder
+{
+    const QVector<QString> *keys;
+    bool operator()(int a, int b) const { return keys->at(a) < keys->at(b); }
+};
+
+// Fuzzy match: number of characters skipped between the first and the last matched character,
+// then the length of the id, so that compact and short matches come first
+struct FuzzyMatch
+{
+    int gaps;
+    int length;
+    int entry;
+    bool operator<(const FuzzyMatch &other) const
+    {
+        if (gaps != other.gaps) return gaps < other.gaps;
+        if (length != other.length) return length < other.length;
+        return entry < other.entry;
+    }
+};
+
+SearchIndex::SearchIndex(const QStringList &ids)
+{
+    keys.reserve(ids.count());
+    masks.reserve(ids.count());
+    sorted.reserve(ids.count());
+    for (int i = 0; i < ids.count(); ++i)
+    {
+        QString key = ids[i].toLower();
+        keys.append(key);
+        masks.append(mask(key));
+        sorted.append(i);
+
+        // Ids are visited in order, so the lists stay sorted; an id repeating a trigram is only
+        // added once
+        for (int c = 0; c + 3 <= key.length(); ++c)
+        {
+            QVector<int> &list = trigrams[trigram(key.constData() + c)];
+            if (list.isEmpty() || list.last() != i)
+                list.append(i);
+        }
+    }
+
+    KeyOrder order;
+    order.keys = &keys;
+    qSort(sorted.begin(), sorted.end(), order);
+}
+
+int SearchIndex::count() const
+{
+    return keys.count();
+}
+
+QVector<int> SearchIndex::find(const QString &text, int limit) const
+{
+    QVector<int> result;
+    QString key = text.trimmed().toLower();
+    if (key.isEmpty() || limit <= 0) return result;
+
+    QVector<bool> found(keys.count(), false);
+    findPrefix(key, limit, result, found);
+    if (result.count() < limit)
+        findSubstring(key, limit, result, found);
+    if (result.count() < limit)
+        findFuzzy(key, limit, result, found);
+    return result;
+}
+
+void SearchIndex::findPrefix(const QString &key, int limit, QVector<int> &result, QVector<bool> &found) const
+{
+    // Binary search for the first key not below the text; all the keys starting with it follow
+    int low = 0, high = sorted.count();
+    while (low < high)
+    {
+        int middle = (low + high) / 2;
+        if (keys[sorted[middle]] < key)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    for (int i = low; i < sorted.count() && result.count() < limit; ++i)
+    {
+        int entry = sorted[i];
+        if (!keys[entry].startsWith(key)) break;
+        result.append(entry);
+        found[entry] = true;
+    }
+}
+
+void SearchIndex::findSubstring(const QString &key, int limit, QVector<int> &result, QVector<bool> &found) const
+{
+    // Short texts have no trigram to look up, but match so many ids that a scan stops early
+    if (key.length() < 3)
+    {
+        for (int i = 0; i < keys.count() && result.count() < limit; ++i)
+            if (!found[i] && keys[i].contains(key))
+            {
+                result.append(i);
+                found[i] = true;
+            }
+        return;
+    }
+
+    // Only the ids containing the rarest trigram of the text need to be checked
+    const QVector<int> *rarest = 0;
+    for (int c = 0; c + 3 <= key.length(); ++c)
+    {
+        QHash<quint64, QVector<int> >::const_iterator list = trigrams.constFind(trigram(key.constData() + c));
+        if (list == trigrams.constEnd()) return;
+        if (!rarest || list->count() < rarest->count())
+            rarest = &list.value();
+    }
+
+    for (int i = 0; i < rarest->count() && result.count() < limit; ++i)
+    {
+        int entry = rarest->at(i);
+        if (!found[entry] && keys[entry].contains(key))
+        {
+            result.append(entry);
+            found[entry] = true;
+        }
+    }
+}
+
+void SearchIndex::findFuzzy(const QString &key, int limit, QVector<int> &result, QVector<bool> &found) const
+{
+    // The candidates share at least a third of the distinct trigrams of the text, counted over
+    // the trigram lists, so that the ids with nothing in common are never visited; texts shorter
+    // than a trigram are matched against all the ids
+    QVector<int> candidates;
+    if (key.length() < 3)
+    {
+        candidates.reserve(keys.count());
+        for (int i = 0; i < keys.count(); ++i)
+            candidates.append(i);
+    }
+    else
+    {
+        QSet<quint64> keyTrigrams;
+        for (int c = 0; c + 3 <= key.length(); ++c)
+            keyTrigrams.insert(trigram(key.constData() + c));
+        int needed = qMax(1, keyTrigrams.count() / 3);
+        QHash<int, int> shared;
+        QSet<quint64>::const_iterator t;
+        for (t = keyTrigrams.constBegin(); t != keyTrigrams.constEnd(); ++t)
+        {
+            QHash<quint64, QVector<int> >::const_iterator list = trigrams.constFind(*t);
+            if (list == trigrams.constEnd()) continue;
+            for (int j = 0; j < list->count(); ++j)
+                ++shared[list->at(j)];
+        }
+        QHash<int, int>::const_iterator entry;
+        for (entry = shared.constBegin(); entry != shared.constEnd(); ++entry)
+            if (entry.value() >= needed)
+                candidates.append(entry.key());
+    }
+
+    quint64 keyMask = mask(key);
+    QVector<FuzzyMatch> matches;
+    for (int k = 0; k < candidates.count(); ++k)
+    {
+        int i = candidates[k];
+        if (found[i] || (masks[i] & keyMask) != keyMask) continue;
+
+        // Match the characters of the text in order, as early as possible
+        const QString &candidate = keys[i];
+        int first = -1, position = 0, c = 0;
+        for (; c < key.length(); ++c)
+        {
+            position = candidate.indexOf(key[c], position);
+            if (position < 0) break;
+            if (first < 0) first = position;
+            ++position;
+        }
+        if (c < key.length()) continue;
+
+        FuzzyMatch match;
+        match.gaps = position - first - key.length();
+        match.length = candidate.length();
+        match.entry = i;
+        matches.append(match);
+    }
+
+    qSort(matches);
+    for (int i = 0; i < matches.count() && result.count() < limit; ++i)
+    {
+        result.append(matches[i].entry);
+        found[matches[i].entry] = true;
+    }
+}
+
+quint64 SearchIndex::trigram(const QChar *c)
+{
+    return (quint64(c[0].unicode()) << 32) | (quint64(c[1].unicode()) << 16) | quint64(c[2].unicode());
+}
+
+quint64 SearchIndex::mask(const QString &key)
+{
+    // Letters and digits have a bit each, and all other characters share one per low bits of
+    // their code
+    quint64 result = 0;
+    for (int i = 0; i < key.length(); ++i)
+    {
+        ushort c = key[i].unicode();
+        if (c >= 'a' && c <= 'z')
+            result |= quint64(1) << (c - 'a');
+        else if (c >= '0' && c <= '9')
+            result |= quint64(1) << (26 + c - '0');
+        else
+            result |= quint64(1) << (36 + c % 28);
+    }
+    return result;
+}
@@ -0,0 +1,68 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <QVector>
+#include <QHash>
+#include <QStringList>
+
+class SearchIndex
+{
+public:
+    // Builds the index over a list of ids; matches are returned as positions in this list
+    explicit SearchIndex(const QStringList &ids = QStringList());
+
+    // Number of indexed ids
+    int count() const;
+
+    // Finds up to 'limit' ids matching a text, ignoring case: ids starting with the text come
+    // first, then ids containing it, then ids containing its characters in the same order and
+    // sharing at least a third of its trigrams
+    QVector<int> find(const QString &text, int limit) const;
+
+private:
+    // Ids in lower case
+    QVector<QString> keys;
+
+    // Id positions ordered by key, for the prefix search
+    QVector<int> sorted;
+
+    // Positions of the ids containing each sequence of three characters, in ascending order
+    QHash<quint64, QVector<int> > trigrams;
+
+    // Characters present in each id, one bit per class, to discard fuzzy candidates quickly
+    QVector<quint64> masks;
+
+    // Each search stage appends new matches to 'result' until it holds 'limit' ids
+    void findPrefix(const QString &key, int limit, QVector<int> &result, QVector<bool> &found) const;
+    void findSubstring(const QString &key, int limit, QVector<int> &result, QVector<bool> &found) const;
+    void findFuzzy(const QString &key, int limit, QVector<int> &result, QVector<bool> &found) const;
+
+    // Key of the three characters starting at 'c'
+    static quint64 trigram(const QChar *c);
+
+    // Character classes present in a key
+    static quint64 mask(const QString &key);
+};
+
+#endif // SEARCHINDEX_H
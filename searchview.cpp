@@ -0,0 +1,191 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#include "searchview.h"
+#include "model.h"
+#include "item.h"
+
+#include <QLineEdit>
+#include <QListWidget>
+#include <QVBoxLayout>
+#include <QtConcurrentRun>
+
+SearchView::SearchView(QWidget *parent) : QWidget(parent)
+{
+    model = 0;
+    searchPending = false;
+
+    searchBox = new QLineEdit(this);
+    searchBox->setPlaceholderText(tr("Search element ids"));
+    resultList = new QListWidget(this);
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addWidget(searchBox);
+    layout->addWidget(resultList);
+
+    searchTimer.setSingleShot(true);
+    searchTimer.setInterval(80);
+    rebuildTimer.setSingleShot(true);
+    rebuildTimer.setInterval(500);
+
+    connect(searchBox, SIGNAL(textEdited(QString)), this, SLOT(textEdited()));
+    connect(searchBox, SIGNAL(returnPressed()), this, SLOT(pickFirst()));
+    connect(resultList, SIGNAL(itemActivated(QListWidgetItem*)), this, SLOT(pick(QListWidgetItem*)));
+    connect(&searchTimer, SIGNAL(timeout()), this, SLOT(search()));
+    connect(&rebuildTimer, SIGNAL(timeout()), this, SLOT(rebuild()));
+    connect(&searchWatcher, SIGNAL(finished()), this, SLOT(searchFinished()));
+    connect(&indexWatcher, SIGNAL(finished()), this, SLOT(indexBuilt()));
+}
+
+void SearchView::setModel(Model *model)
+{
+    if (this->model) disconnect(this->model, 0, this, 0);
+    this->model = model;
+    connect(model, SIGNAL(modelReset()), this, SLOT(invalidate()));
+    connect(model, SIGNAL(rowsRemoved(QModelIndex, int, int)), this, SLOT(invalidate()));
+    invalidate();
+}
+
+void SearchView::activate()
+{
+    searchBox->setFocus();
+    searchBox->selectAll();
+}
+
+void SearchView::textEdited()
+{
+    searchTimer.start();
+}
+
+void SearchView::search()
+{
+    // Only one search runs at a time; the latest text is searched when it finishes
+    if (searchWatcher.isRunning())
+    {
+        searchPending = true;
+        return;
+    }
+    searchPending = false;
+    if (index.isNull()) return;
+
+    searchWatcher.setFuture(QtConcurrent::run(find, index, searchBox->text()));
+}
+
+void SearchView::searchFinished()
+{
+    if (searchPending)
+    {
+        search();
+        return;
+    }
+
+    // Results from an index replaced meanwhile may point to removed items
+    Results results = searchWatcher.result();
+    if (results.index != index) return;
+
+    // Type of element of each XMLElement value
+    static const char *typeNames[] = { "edge", "lane", "junction", "connection", "tlLogic", "request", "phase" };
+
+    resultList->clear();
+    resultItems.clear();
+    for (int i = 0; i < results.entries.count(); ++i)
+    {
+        Item *item = index->items[results.entries[i]];
+        resultItems.append(item);
+        resultList->addItem(QString("%1 (%2)").arg(item->name).arg(typeNames[item->type]));
+    }
+}
+
+void SearchView::invalidate()
+{
+    // Items may have been deleted, so neither the index nor the results can be used any more
+    index.clear();
+    resultList->clear();
+    resultItems.clear();
+    rebuildTimer.start();
+}
+
+void SearchView::rebuild()
+{
+    if (!model) return;
+    if (indexWatcher.isRunning())
+    {
+        rebuildTimer.start();
+        return;
+    }
+
+    // The items are collected here, since the model may change while the index is built
+    QStringList ids;
+    QVector<Item*> items;
+    model->searchItems(ids, items);
+    indexWatcher.setFuture(QtConcurrent::run(buildIndex, ids, items));
+}
+
+void SearchView::indexBuilt()
+{
+    // The model changed again while the index was built
+    if (rebuildTimer.isActive()) return;
+
+    index = indexWatcher.result();
+    if (!searchBox->text().isEmpty()) search();
+}
+
+void SearchView::pick(QListWidgetItem *result)
+{
+    int row = resultList->row(result);
+    if (row >= 0 && row < resultItems.count())
+        emit itemPicked(resultItems[row]);
+}
+
+void SearchView::pickFirst()
+{
+    // Search first if the text changed since the last results
+    if (searchTimer.isActive() || searchWatcher.isRunning())
+    {
+        searchTimer.stop();
+        if (index.isNull()) return;
+        Results results = find(index, searchBox->text());
+        if (!results.entries.isEmpty())
+            emit itemPicked(index->items[results.entries[0]]);
+        return;
+    }
+
+    if (!resultItems.isEmpty())
+    {
+        resultList->setCurrentRow(0);
+        emit itemPicked(resultItems[0]);
+    }
+}
+
+QSharedPointer<const SearchView::Index> SearchView::buildIndex(QStringList ids, QVector<Item*> items)
+{
+    Index *index = new Index;
+    index->ids = SearchIndex(ids);
+    index->items = items;
+    return QSharedPointer<const Index>(index);
+}
+
+SearchView::Results SearchView::find(QSharedPointer<const Index> index, QString text)
+{
+    Results results;
+    results.index = index;
+    results.entries = index->ids.find(text, maxResults);
+    return results;
+}
@@ -0,0 +1,125 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#ifndef SEARCHVIEW_H
+#define SEARCHVIEW_H
+
+#include "searchindex.h"
+
+#include <QWidget>
+#include <QVector>
+#include <QTimer>
+#include <QSharedPointer>
+#include <QFutureWatcher>
+
+class Model;
+class Item;
+
+QT_BEGIN_NAMESPACE
+class QLineEdit;
+class QListWidget;
+class QListWidgetItem;
+QT_END_NAMESPACE
+
+class SearchView : public QWidget
+{
+    Q_OBJECT
+public:
+    // Constructor
+    explicit SearchView(QWidget *parent = 0);
+
+    // Indexes the ids of the elements of a model, and again whenever elements are removed
+    void setModel(Model *model);
+
+    // Gives the focus to the search box
+    void activate();
+
+signals:
+    // Emitted when a result is picked, to select the element and show it in the network view
+    void itemPicked(Item *item);
+
+private slots:
+    // Waits for the typing to pause before searching
+    void textEdited();
+
+    // Starts searching for the text in a worker thread
+    void search();
+
+    // Lists the results of the last search
+    void searchFinished();
+
+    // Drops the index and indexes the model again after elements have been removed
+    void invalidate();
+
+    // Starts indexing the model in a worker thread
+    void rebuild();
+
+    // Replaces the index with the one just built
+    void indexBuilt();
+
+    // Picks a result from the list, or the first one when Enter is pressed in the search box
+    void pick(QListWidgetItem *result);
+    void pickFirst();
+
+private:
+    // Element ids and the items they belong to, shared read only with the worker threads
+    struct Index
+    {
+        SearchIndex ids;
+        QVector<Item*> items;
+    };
+
+    // Results of a search: positions in the index
+    struct Results
+    {
+        QSharedPointer<const Index> index;
+        QVector<int> entries;
+    };
+
+    // Number of results listed
+    static const int maxResults = 200;
+
+    // Model and index of its ids
+    Model *model;
+    QSharedPointer<const Index> index;
+    QFutureWatcher<QSharedPointer<const Index> > indexWatcher;
+
+    // Search box, results list, and the items of the listed results
+    QLineEdit *searchBox;
+    QListWidget *resultList;
+    QVector<Item*> resultItems;
+
+    // Search running, and whether the text changed meanwhile
+    QFutureWatcher<Results> searchWatcher;
+    bool searchPending;
+
+    // Timers grouping keystrokes and model changes
+    QTimer searchTimer;
+    QTimer rebuildTimer;
+
+    // Builds an index; runs in a worker thread
+    static QSharedPointer<const Index> buildIndex(QStringList ids, QVector<Item*> items);
+
+    // Searches an index; runs in a worker thread
+    static Results find(QSharedPointer<const Index> index, QString text);
+};
+
+#endif // SEARCHVIEW_H
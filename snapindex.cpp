@@ -0,0 +1,133 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#include "snapindex.h"
+#include "pathelement.h"
+#include "pointelement.h"
+
+#include <QGraphicsScene>
+#include <qmath.h>
+
+qreal SnapIndex::tolerance = 1.0;
+
+SnapIndex::SnapIndex()
+{
+}
+
+void SnapIndex::clear()
+{
+    cells.clear();
+    owners.clear();
+}
+
+void SnapIndex::addScene(QGraphicsScene *scene)
+{
+    QList<QGraphicsItem *> allItems = scene->items();
+    PathElement *pathit;
+    PointElement *pointit;
+    for (int i = 0; i < allItems.count(); ++i)
+    {
+        pathit = dynamic_cast <PathElement*>(allItems[i]);
+        if (pathit != NULL)
+            setPoints(pathit, pathit->snapPoints());
+        else
+        {
+            pointit = dynamic_cast <PointElement*>(allItems[i]);
+            if (pointit != NULL)
+                setPoints(pointit, pointit->snapPoints());
+        }
+    }
+}
+
+void SnapIndex::setPoints(QGraphicsItem *owner, const QVector<QPointF> &points)
+{
+    remove(owner);
+    Entry entry;
+    entry.owner = owner;
+    for (int i = 0; i < points.count(); ++i)
+    {
+        entry.point = points[i];
+        cells[cellOf(points[i])].append(entry);
+    }
+    owners.insert(owner, points);
+}
+
+void SnapIndex::remove(QGraphicsItem *owner)
+{
+    // Find the cells of the previous points of the element and take its entries out of them
+    QHash<QGraphicsItem*, QVector<QPointF> >::iterator old = owners.find(owner);
+    if (old == owners.end()) return;
+    for (int i = 0; i < old->count(); ++i)
+    {
+        QHash<qint64, QVector<Entry> >::iterator cell = cells.find(cellOf(old->at(i)));
+        if (cell == cells.end()) continue;
+        for (int j = cell->count() - 1; j >= 0; --j)
+            if (cell->at(j).owner == owner)
+                cell->remove(j);
+        if (cell->isEmpty())
+            cells.erase(cell);
+    }
+    owners.erase(old);
+}
+
+bool SnapIndex::nearest(const QPointF &point, const QGraphicsItem *exclude, QPointF &result) const
+{
+    // Only the cells within the tolerance are visited
+    qreal radius = qMin(tolerance, qreal(maxRadius));
+    int x0 = qFloor((point.x() - radius) / cellSize), x1 = qFloor((point.x() + radius) / cellSize);
+    int y0 = qFloor((point.y() - radius) / cellSize), y1 = qFloor((point.y() + radius) / cellSize);
+    qreal best = radius * radius, d;
+    bool found = false;
+    for (int y = y0; y <= y1; ++y)
+        for (int x = x0; x <= x1; ++x)
+        {
+            QHash<qint64, QVector<Entry> >::const_iterator cell = cells.constFind(key(x, y));
+            if (cell == cells.constEnd()) continue;
+            for (int i = 0; i < cell->count(); ++i)
+            {
+                const Entry &entry = cell->at(i);
+                if (entry.owner == exclude || !entry.owner->isVisible()) continue;
+                d = (entry.point.x() - point.x()) * (entry.point.x() - point.x()) + (entry.point.y() - point.y()) * (entry.point.y() - point.y());
+                if (d <= best)
+                {
+                    best = d;
+                    result = entry.point;
+                    found = true;
+                }
+            }
+        }
+    return found;
+}
+
+void SnapIndex::setTolerance(qreal tolerance)
+{
+    SnapIndex::tolerance = tolerance;
+}
+
+qint64 SnapIndex::cellOf(const QPointF &point)
+{
+    return key(qFloor(point.x() / cellSize), qFloor(point.y() / cellSize));
+}
+
+qint64 SnapIndex::key(int x, int y)
+{
+    return (qint64(x) << 32) | quint32(y);
+}
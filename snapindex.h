@@ -0,0 +1,86 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#ifndef SNAPINDEX_H
+#define SNAPINDEX_H
+
+#include <QVector>
+#include <QHash>
+#include <QPointF>
+
+QT_BEGIN_NAMESPACE
+class QGraphicsItem;
+class QGraphicsScene;
+QT_END_NAMESPACE
+
+class SnapIndex
+{
+public:
+    // Constructor
+    SnapIndex();
+
+    // Removes all points
+    void clear();
+
+    // Indexes the shape vertices of all the Path Elements and the points of the Point Elements in a scene
+    void addScene(QGraphicsScene *scene);
+
+    // Replaces the points of an element, e.g. after it has been edited
+    void setPoints(QGraphicsItem *owner, const QVector<QPointF> &points);
+
+    // Removes the points of an element
+    void remove(QGraphicsItem *owner);
+
+    // Finds the nearest point of a visible element other than 'exclude' within the snap
+    // tolerance, capped at maxRadius; returns false if there is none
+    bool nearest(const QPointF &point, const QGraphicsItem *exclude, QPointF &result) const;
+
+    // Sets the snap tolerance in scene units; called by the network view when the zoom changes
+    static void setTolerance(qreal tolerance);
+
+private:
+    // Indexed point and the element it belongs to
+    struct Entry
+    {
+        QPointF point;
+        QGraphicsItem *owner;
+    };
+
+    // Grid of points, keyed by cell; the cell size is in metres
+    QHash<qint64, QVector<Entry> > cells;
+    static const int cellSize = 20;
+
+    // The tolerance is a few pixels, which is a long way at low zoom; the search radius is capped
+    // so that a query never visits more than (2 * maxRadius / cellSize + 1)^2 cells
+    static const int maxRadius = 200;
+
+    // Points of each element, so that they can be found again when the element changes
+    QHash<QGraphicsItem*, QVector<QPointF> > owners;
+
+    // Snap tolerance in scene units, shared by all the indexes
+    static qreal tolerance;
+
+    // Cell of a point
+    static qint64 cellOf(const QPointF &point);
+    static qint64 key(int x, int y);
+};
+
+#endif // SNAPINDEX_H
@@ -0,0 +1,160 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#include "statsoverlay.h"
+
+#include <QPainter>
+#include <QtAlgorithms>
+
+StatsOverlay::StatsOverlay(QWidget *parent) : QWidget(parent)
+{
+    // Opaque panel, so that refreshing it does not repaint the scene underneath
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setFixedSize(340, 225);
+
+    // Keep the last 120 frames
+    frameTimes.fill(0, 120);
+    nextFrame = 0;
+    frames = 0;
+    lastIndexMs = 0;
+    lastCandidates = 0;
+    for (int i = 0; i < PaintStats::CategoryCount; ++i)
+        painted[i] = culled[i] = overlaid[i] = 0;
+}
+
+void StatsOverlay::addFrame(qreal frameMs, qreal indexMs, int candidates, const int *totals)
+{
+    // Store the figures of the frame
+    frameTimes[nextFrame] = frameMs;
+    nextFrame = (nextFrame + 1) % frameTimes.size();
+    if (frames < frameTimes.size()) ++frames;
+    lastIndexMs = indexMs;
+    lastCandidates = candidates;
+    for (int i = 0; i < PaintStats::CategoryCount; ++i)
+    {
+        painted[i] = PaintStats::paintCalls[PaintStats::BackgroundPass][i];
+        culled[i] = qMax(0, totals[i] - painted[i]);
+        overlaid[i] = PaintStats::paintCalls[PaintStats::ItemPass][i];
+    }
+
+    // Write a line in the log
+    if (logFile.isOpen())
+    {
+        log << clock.elapsed() << "," << QString::number(frameMs, 'f', 3) << "," << QString::number(indexMs, 'f', 3)
+            << "," << candidates << "," << PaintStats::total(PaintStats::BackgroundPass)
+            << "," << PaintStats::total(PaintStats::ItemPass);
+        for (int i = 0; i < PaintStats::CategoryCount; ++i)
+            log << "," << painted[i] << "," << culled[i] << "," << overlaid[i];
+        log << "\n";
+    }
+
+    if (isVisible()) update();
+}
+
+qreal StatsOverlay::percentile(qreal p) const
+{
+    if (frames == 0) return 0;
+    QVector<qreal> sorted = frameTimes.mid(0, frames);
+    qSort(sorted);
+    int i = qMin(frames - 1, int(p / 100 * frames));
+    return sorted[i];
+}
+
+void StatsOverlay::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), QColor(32, 32, 32));
+    painter.setPen(Qt::white);
+
+    // Frame and index figures
+    int last = (nextFrame + frameTimes.size() - 1) % frameTimes.size();
+    int y = 14;
+    painter.drawText(8, y, tr("Frame: %1 ms   p50 %2  p95 %3  p99 %4")
+                     .arg(frameTimes[last], 0, 'f', 1).arg(percentile(50), 0, 'f', 1)
+                     .arg(percentile(95), 0, 'f', 1).arg(percentile(99), 0, 'f', 1));
+    y += 15;
+    painter.drawText(8, y, tr("Index query: %1 ms, %2 items").arg(lastIndexMs, 0, 'f', 2).arg(lastCandidates));
+    y += 15;
+    painter.drawText(8, y, tr("paint() calls: %1 background, %2 items").arg(PaintStats::total(PaintStats::BackgroundPass))
+                     .arg(PaintStats::total(PaintStats::ItemPass)));
+
+    // Items painted into the background and culled from it, and items painted over it, per category
+    for (int i = 0; i < PaintStats::CategoryCount; ++i)
+    {
+        y += 15;
+        painter.drawText(8, y, QString(PaintStats::name(i)));
+        painter.drawText(100, y, tr("%1 painted").arg(painted[i]));
+        painter.drawText(185, y, tr("%1 culled").arg(culled[i]));
+        painter.drawText(265, y, tr("%1 over").arg(overlaid[i]));
+    }
+
+    // Frame time graph: one bar per frame, oldest on the left, scaled to 50 ms
+    QRect graph(8, y + 8, width() - 16, height() - y - 14);
+    painter.fillRect(graph, QColor(48, 48, 48));
+    qreal barWidth = qreal(graph.width()) / frameTimes.size();
+    for (int i = 0; i < frames; ++i)
+    {
+        int frame = (nextFrame + frameTimes.size() - frames + i) % frameTimes.size();
+        qreal h = qMin(qreal(1), frameTimes[frame] / 50) * graph.height();
+        QColor colour = (frameTimes[frame] > 33.3 ? QColor(220, 60, 60) : (frameTimes[frame] > 16.7 ? QColor(230, 180, 40) : QColor(80, 200, 80)));
+        painter.fillRect(QRectF(graph.left() + i * barWidth, graph.bottom() - h, qMax(qreal(1), barWidth - 1), h), colour);
+    }
+
+    // Reference lines at 60 fps and at the 95th percentile
+    painter.setPen(QPen(QColor(160, 160, 160), 0, Qt::DotLine));
+    qreal y60 = graph.bottom() - 16.7 / 50 * graph.height();
+    painter.drawLine(QPointF(graph.left(), y60), QPointF(graph.right(), y60));
+    painter.setPen(QPen(QColor(80, 160, 255), 0, Qt::DashLine));
+    qreal y95 = graph.bottom() - qMin(qreal(1), percentile(95) / 50) * graph.height();
+    painter.drawLine(QPointF(graph.left(), y95), QPointF(graph.right(), y95));
+}
+
+bool StatsOverlay::startLog(const QString &fileName)
+{
+    stopLog();
+    logFile.setFileName(fileName);
+    if (!logFile.open(QIODevice::WriteOnly | QIODevice::Text)) return false;
+    log.setDevice(&logFile);
+
+    // Header line
+    log << "time_ms,frame_ms,index_ms,index_items,background_calls,item_calls";
+    for (int i = 0; i < PaintStats::CategoryCount; ++i)
+        log << "," << PaintStats::name(i) << "_painted," << PaintStats::name(i) << "_culled," << PaintStats::name(i) << "_over";
+    log << "\n";
+    clock.start();
+    return true;
+}
+
+void StatsOverlay::stopLog()
+{
+    if (logFile.isOpen())
+    {
+        log.flush();
+        log.setDevice(0);
+        logFile.close();
+    }
+}
+
+bool StatsOverlay::isLogging() const
+{
+    return logFile.isOpen();
+}
@@ -0,0 +1,74 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#ifndef STATSOVERLAY_H
+#define STATSOVERLAY_H
+
+#include "paintstats.h"
+
+#include <QWidget>
+#include <QVector>
+#include <QFile>
+#include <QTextStream>
+#include <QElapsedTimer>
+
+class StatsOverlay : public QWidget
+{
+    Q_OBJECT
+public:
+    // Constructor
+    explicit StatsOverlay(QWidget *parent = 0);
+
+    // Records the statistics of a frame; 'totals' are the visible items per category in the scene,
+    // and the culled items are the ones left out of the background pass
+    void addFrame(qreal frameMs, qreal indexMs, int candidates, const int *totals);
+
+    // Starts and stops writing one line per frame into a CSV file
+    bool startLog(const QString &fileName);
+    void stopLog();
+    bool isLogging() const;
+
+protected:
+    // Draws the figures of the last frame and the frame time graph
+    void paintEvent(QPaintEvent *);
+
+private:
+    // Frame times of the last frames (ring buffer) and position of the next one
+    QVector<qreal> frameTimes;
+    int nextFrame, frames;
+
+    // Figures of the last frame
+    qreal lastIndexMs;
+    int lastCandidates;
+    int painted[PaintStats::CategoryCount];
+    int culled[PaintStats::CategoryCount];
+    int overlaid[PaintStats::CategoryCount];
+
+    // Returns the given percentile (0-100) of the frame times in the buffer
+    qreal percentile(qreal p) const;
+
+    // CSV log
+    QFile logFile;
+    QTextStream log;
+    QElapsedTimer clock;
+};
+
+#endif // STATSOVERLAY_H
@@ -0,0 +1,77 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#include "transformdialog.h"
+
+#include <QDoubleSpinBox>
+#include <QFormLayout>
+#include <QDialogButtonBox>
+
+// Creates a spin box with a range, a default value and a suffix
+static QDoubleSpinBox *createSpinBox(double min, double max, double value, int decimals, const QString &suffix)
+{
+    QDoubleSpinBox *box = new QDoubleSpinBox;
+    box->setRange(min, max);
+    box->setDecimals(decimals);
+    box->setValue(value);
+    box->setSuffix(suffix);
+    return box;
+}
+
+TransformDialog::TransformDialog(const QPointF &centre, QWidget *parent) : QDialog(parent), centre(centre)
+{
+    setWindowTitle(tr("Transform Elements"));
+
+    translateX = createSpinBox(-1e7, 1e7, 0, 2, tr(" m"));
+    translateY = createSpinBox(-1e7, 1e7, 0, 2, tr(" m"));
+    rotation = createSpinBox(-360, 360, 0, 3, tr(" deg"));
+    scaleX = createSpinBox(-1000, 1000, 1, 4, QString());
+    scaleY = createSpinBox(-1000, 1000, 1, 4, QString());
+    shearX = createSpinBox(-100, 100, 0, 4, QString());
+    shearY = createSpinBox(-100, 100, 0, 4, QString());
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    connect(buttons, SIGNAL(accepted()), this, SLOT(accept()));
+    connect(buttons, SIGNAL(rejected()), this, SLOT(reject()));
+
+    QFormLayout *layout = new QFormLayout(this);
+    layout->addRow(tr("Translate X:"), translateX);
+    layout->addRow(tr("Translate Y:"), translateY);
+    layout->addRow(tr("Rotate (counterclockwise):"), rotation);
+    layout->addRow(tr("Scale X:"), scaleX);
+    layout->addRow(tr("Scale Y:"), scaleY);
+    layout->addRow(tr("Shear X (x += s * y):"), shearX);
+    layout->addRow(tr("Shear Y (y += s * x):"), shearY);
+    layout->addRow(buttons);
+}
+
+QTransform TransformDialog::transform() const
+{
+    // Points are mapped by the last transform first: moved to the origin, scaled, sheared,
+    // rotated, moved back to the centre and translated
+    QTransform t;
+    t.translate(centre.x() + translateX->value(), centre.y() + translateY->value());
+    t.rotate(rotation->value());
+    t.shear(shearX->value(), shearY->value());
+    t.scale(scaleX->value(), scaleY->value());
+    t.translate(-centre.x(), -centre.y());
+    return t;
+}
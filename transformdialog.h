@@ -0,0 +1,48 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#ifndef TRANSFORMDIALOG_H
+#define TRANSFORMDIALOG_H
+
+#include <QDialog>
+#include <QTransform>
+#include <QPointF>
+
+QT_BEGIN_NAMESPACE
+class QDoubleSpinBox;
+QT_END_NAMESPACE
+
+class TransformDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    // Constructor; rotation and scaling are done about 'centre'
+    explicit TransformDialog(const QPointF &centre, QWidget *parent = 0);
+
+    // Transform entered: scaling, shearing and rotation about the centre, then translation
+    QTransform transform() const;
+
+private:
+    QPointF centre;
+    QDoubleSpinBox *translateX, *translateY, *rotation, *scaleX, *scaleY, *shearX, *shearY;
+};
+
+#endif // TRANSFORMDIALOG_H
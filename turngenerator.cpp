@@ -0,0 +1,274 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#include "turngenerator.h"
+#include "model.h"
+#include "pathelement.h"
+#include "pointelement.h"
+
+#include <QLineF>
+#include <QtConcurrentMap>
+
+TurnGenerator::TurnGenerator(Model *model) : QObject()
+{
+    this->model = model;
+    generation = 0;
+    jobGeneration = 0;
+    connect(&watcher, SIGNAL(finished()), this, SLOT(turnsComputed()));
+}
+
+TurnGenerator::~TurnGenerator()
+{
+    watcher.waitForFinished();
+}
+
+void TurnGenerator::clear()
+{
+    turns.clear();
+    startJunctions.clear();
+    endJunctions.clear();
+    users.clear();
+    dirty.clear();
+    ++generation;
+}
+
+void TurnGenerator::addTurn(Item *junction, const Turn &turn)
+{
+    turns[junction].append(turn);
+    if (!endJunctions[turn.from].contains(junction)) endJunctions[turn.from].append(junction);
+    if (!startJunctions[turn.to].contains(junction)) startJunctions[turn.to].append(junction);
+    users[turn.from].insert(junction);
+    users[turn.to].insert(junction);
+    for (int j = 0; j < turn.paths.count(); ++j)
+        users[turn.paths[j]].insert(junction);
+    for (int j = 0; j < turn.points.count(); ++j)
+        users[turn.points[j]].insert(junction);
+}
+
+void TurnGenerator::indexTurns(Item *junction, bool add)
+{
+    const QList<Turn> &list = turns.value(junction);
+    for (int i = 0; i < list.count(); ++i)
+    {
+        const Turn &turn = list[i];
+        if (add)
+        {
+            if (!endJunctions[turn.from].contains(junction)) endJunctions[turn.from].append(junction);
+            if (!startJunctions[turn.to].contains(junction)) startJunctions[turn.to].append(junction);
+        }
+        else
+        {
+            QHash<PathElement*, QList<Item*> >::iterator lane = endJunctions.find(turn.from);
+            if (lane != endJunctions.end() && lane->removeAll(junction) > 0 && lane->isEmpty()) endJunctions.erase(lane);
+            lane = startJunctions.find(turn.to);
+            if (lane != startJunctions.end() && lane->removeAll(junction) > 0 && lane->isEmpty()) startJunctions.erase(lane);
+        }
+
+        QList<QGraphicsItem*> elements;
+        elements << turn.from << turn.to;
+        for (int j = 0; j < turn.paths.count(); ++j)
+            elements << turn.paths[j];
+        for (int j = 0; j < turn.points.count(); ++j)
+            elements << turn.points[j];
+        for (int j = 0; j < elements.count(); ++j)
+        {
+            if (add)
+            {
+                users[elements[j]].insert(junction);
+                continue;
+            }
+            QHash<QGraphicsItem*, QSet<Item*> >::iterator user = users.find(elements[j]);
+            if (user == users.end()) continue;
+            user->remove(junction);
+            if (user->isEmpty()) users.erase(user);
+        }
+    }
+}
+
+void TurnGenerator::removeJunction(Item *junction)
+{
+    // The junction is taken out of the indices through its own turns
+    indexTurns(junction, false);
+    turns.remove(junction);
+    dirty.remove(junction);
+    ++generation;
+}
+
+void TurnGenerator::forget(const QSet<QGraphicsItem*> &elements)
+{
+    // Only the junctions using any of the elements are visited
+    QSet<Item*> junctions;
+    QSet<QGraphicsItem*>::const_iterator element;
+    for (element = elements.constBegin(); element != elements.constEnd(); ++element)
+    {
+        QHash<QGraphicsItem*, QSet<Item*> >::const_iterator user = users.constFind(*element);
+        if (user != users.constEnd()) junctions.unite(*user);
+    }
+    if (junctions.isEmpty()) return;
+
+    // Drop the turns that start, end or run along any of the elements, and index the rest again
+    QSet<Item*>::const_iterator junction;
+    for (junction = junctions.constBegin(); junction != junctions.constEnd(); ++junction)
+    {
+        indexTurns(*junction, false);
+        QList<Turn> &list = turns[*junction];
+        for (int i = list.count() - 1; i >= 0; --i)
+        {
+            const Turn &turn = list[i];
+            bool uses = (elements.contains(turn.from) || elements.contains(turn.to));
+            for (int j = 0; !uses && j < turn.paths.count(); ++j)
+                uses = elements.contains(turn.paths[j]);
+            for (int j = 0; !uses && j < turn.points.count(); ++j)
+                uses = elements.contains(turn.points[j]);
+            if (uses) list.removeAt(i);
+        }
+        indexTurns(*junction, true);
+    }
+    ++generation;
+}
+
+void TurnGenerator::regenerate(PathElement *lane, bool atStart, bool commit)
+{
+    const QList<Item*> &junctions = (atStart ? startJunctions : endJunctions).value(lane);
+    if (junctions.isEmpty()) return;
+    for (int i = 0; i < junctions.count(); ++i)
+        markDirty(junctions[i], commit);
+    startNext();
+}
+
+void TurnGenerator::markDirty(Item *junction, bool commit)
+{
+    dirty[junction] = dirty.value(junction) || commit;
+}
+
+void TurnGenerator::startNext()
+{
+    if (watcher.isRunning() || dirty.isEmpty()) return;
+
+    // Copy the ends of the approach and departure lanes of every turn
+    QVector<Input> inputs;
+    Input input;
+    QHash<Item*, bool>::const_iterator it;
+    for (it = dirty.constBegin(); it != dirty.constEnd(); ++it)
+    {
+        const QList<Turn> &list = turns.value(it.key());
+        for (int i = 0; i < list.count(); ++i)
+        {
+            const QList<QPointF> &from = list[i].from->pathNodes();
+            const QList<QPointF> &to = list[i].to->pathNodes();
+            if (from.isEmpty() || to.isEmpty()) continue;
+
+            input.junction = it.key();
+            input.turn = i;
+            input.a = from.last();
+            input.da = (from.count() > 1 ? from.last() - from[from.count() - 2] : QPointF());
+            input.b = to.first();
+            input.db = (to.count() > 1 ? to[1] - to.first() : QPointF());
+            input.pieces = list[i].pieces;
+            inputs.append(input);
+        }
+    }
+    running = dirty;
+    dirty.clear();
+    jobGeneration = generation;
+    watcher.setFuture(QtConcurrent::mapped(inputs, compute));
+}
+
+TurnGenerator::Shape TurnGenerator::compute(const Input &input)
+{
+    Shape shape;
+    shape.junction = input.junction;
+    shape.turn = input.turn;
+
+    // The control points lie a third of the distance between the lanes along their directions
+    qreal k = QLineF(input.a, input.b).length() / 3;
+    qreal la = QLineF(QPointF(), input.da).length(), lb = QLineF(QPointF(), input.db).length();
+    QPointF c1 = input.a + (la > 0 ? input.da * (k / la) : QPointF());
+    QPointF c2 = input.b - (lb > 0 ? input.db * (k / lb) : QPointF());
+
+    int segments = pieceSegments * input.pieces;
+    QPolygonF curve;
+    qreal t, s;
+    for (int i = 0; i <= segments; ++i)
+    {
+        t = qreal(i) / segments;
+        s = 1 - t;
+        curve << s * s * s * input.a + 3 * s * s * t * c1 + 3 * s * t * t * c2 + t * t * t * input.b;
+    }
+
+    // Consecutive pieces share their end points
+    for (int p = 0; p < input.pieces; ++p)
+        shape.pieces.append(curve.mid(p * pieceSegments, pieceSegments + 1));
+    return shape;
+}
+
+void TurnGenerator::turnsComputed()
+{
+    QList<Shape> shapes = watcher.future().results();
+
+    // Turns were removed meanwhile: compute the junctions that are left again
+    if (jobGeneration != generation)
+    {
+        QHash<Item*, bool>::const_iterator it;
+        for (it = running.constBegin(); it != running.constEnd(); ++it)
+            if (turns.contains(it.key())) markDirty(it.key(), it.value());
+        running.clear();
+        startNext();
+        return;
+    }
+
+    model->beginUpdate();
+    for (int i = 0; i < shapes.count(); ++i)
+    {
+        const Shape &shape = shapes[i];
+        const Turn &turn = turns[shape.junction][shape.turn];
+        QPointF end = shape.pieces.last().last();
+        for (int j = 0; j < turn.paths.count(); ++j)
+        {
+            int piece = turn.piece[j];
+            if (piece >= 0)
+                turn.paths[j]->followShape(shape.pieces[piece].toList());
+            else
+                turn.paths[j]->followShape(QList<QPointF>() << end << end);
+        }
+        for (int j = 0; j < turn.points.count(); ++j)
+            turn.points[j]->follow(end - turn.points[j]->position());
+    }
+
+    // Write the shapes of the junctions whose edit is finished
+    QHash<Item*, bool>::const_iterator it;
+    for (it = running.constBegin(); it != running.constEnd(); ++it)
+    {
+        if (!it.value()) continue;
+        const QList<Turn> &list = turns.value(it.key());
+        for (int i = 0; i < list.count(); ++i)
+        {
+            for (int j = 0; j < list[i].paths.count(); ++j)
+                list[i].paths[j]->endFollow();
+            for (int j = 0; j < list[i].points.count(); ++j)
+                list[i].points[j]->endFollow();
+        }
+    }
+    model->endUpdate();
+    running.clear();
+
+    startNext();
+}
@@ -0,0 +1,136 @@
+/***************************************************************************
+ *  Copyright (c) 2014 Martin Llavallol <m5lmodelling@gmail.com>           *
+ *                                                                         *
+ *  This file is part of Network Editor for SUMO.                          *
+ *                                                                         *
+ *  Network Editor for SUMO is free software: you can redistribute it      *
+ *  and/or modify it under the terms of the GNU General Public License     *
+ *  as published by the Free Software Foundation, either version 3 of      *
+ *  the License, or (at your option) any later version.                    *
+ *                                                                         *
+ *  Network Editor for SUMO is distributed in the hope that it will be     *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty     *
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with Network Editor for SUMO.  If not, see                       *
+ *  <http://www.gnu.org/licenses/>.                                        *
+ ***************************************************************************/
+
+
+#ifndef TURNGENERATOR_H
+#define TURNGENERATOR_H
+
+#include <QObject>
+#include <QList>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QPointF>
+#include <QPolygonF>
+#include <QFutureWatcher>
+
+class Model;
+class Item;
+class PathElement;
+class PointElement;
+
+QT_BEGIN_NAMESPACE
+class QGraphicsItem;
+QT_END_NAMESPACE
+
+class TurnGenerator : public QObject
+{
+    Q_OBJECT
+public:
+    // Movement through a junction, from the end of an approach lane to the start of a departure lane.
+    // The curve between both lanes is split evenly among the internal lanes of the turn: each path
+    // follows piece 'piece[i]' of 'pieces', and the paths at the end of the turn (piece -1) and the
+    // points are placed at the start of the departure lane
+    struct Turn
+    {
+        PathElement *from, *to;
+        int pieces;
+        QList<PathElement*> paths;
+        QList<int> piece;
+        QList<PointElement*> points;
+    };
+
+    // Constructor and destructor; the destructor waits for the running job
+    explicit TurnGenerator(Model *model);
+    ~TurnGenerator();
+
+    // Removes all the turns
+    void clear();
+
+    // Adds a turn through a junction
+    void addTurn(Item *junction, const Turn &turn);
+
+    // Removes the turns of a deleted junction, and the turns using deleted elements
+    void removeJunction(Item *junction);
+    void forget(const QSet<QGraphicsItem*> &elements);
+
+    // Regenerates the turns of the junction at the start or end of a lane whose end node moved;
+    // with 'commit' the new shapes are written into the XML domDocument
+    void regenerate(PathElement *lane, bool atStart, bool commit);
+
+private slots:
+    // Starts computing the turns of the dirty junctions in worker threads
+    void startNext();
+
+    // Moves the internal lanes and connections to the computed shapes
+    void turnsComputed();
+
+private:
+    // Copy of the lane ends of a turn, so that the curves are computed away from the scene
+    struct Input
+    {
+        Item *junction;
+        int turn;
+        QPointF a, da, b, db;
+        int pieces;
+    };
+
+    // Computed curve of a turn, split into pieces
+    struct Shape
+    {
+        Item *junction;
+        int turn;
+        QVector<QPolygonF> pieces;
+    };
+
+    // Cubic Bezier curve leaving 'a' along 'da' and reaching 'b' along 'db'; runs in a worker thread
+    static Shape compute(const Input &input);
+
+    // Segments of the curve in each piece
+    static const int pieceSegments = 6;
+
+    Model *model;
+
+    // Turns of each junction, the junctions at the start and end of each lane, and the junctions
+    // whose turns use each element as approach or departure lane, internal lane or point
+    QHash<Item*, QList<Turn> > turns;
+    QHash<PathElement*, QList<Item*> > startJunctions, endJunctions;
+    QHash<QGraphicsItem*, QSet<Item*> > users;
+
+    // Adds the turns of a junction to the lane and element indices, or takes them out of them;
+    // emptied entries are removed
+    void indexTurns(Item *junction, bool add);
+
+    // Junctions waiting to be regenerated, with whether their shapes are to be committed,
+    // and the junctions of the running job
+    QHash<Item*, bool> dirty;
+    QHash<Item*, bool> running;
+
+    // Incremented when turns are removed, so that the results of a previous job are discarded
+    int generation, jobGeneration;
+
+    // Watches the computation of the current job
+    QFutureWatcher<Shape> watcher;
+
+    // Marks a junction to be regenerated
+    void markDirty(Item *junction, bool commit);
+};
+
+#endif // TURNGENERATOR_H